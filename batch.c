@@ -0,0 +1,258 @@
+/*
+ *   This source file is part of program computing set overlap classes 
+ *   in linear time.
+ *   Copyright (C) 2007  Michael Rao
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include "batch.h"
+
+/*
+ * Batch mode: the families of a batch file are computed by a pool of 
+ * threads, each one with its own context (see overlap_ctx_t).
+ * The families are first dealt round-robin to the threads. A thread takes 
+ * its families in increasing order, then steals from the back of the other
+ * threads, so a large family does not stall the others.
+ * The result of a family is written in a buffer; the calling thread writes
+ * the buffers in input order as soon as they are ready.
+ */
+
+/**
+ * Families not yet taken by a thread: t[front..back-1]
+ */
+typedef struct {
+  pthread_mutex_t lock;
+  int *t;
+  int front,back;
+} batch_deque_t;
+
+/**
+ * Shared data of the threads
+ */
+typedef struct {
+  const famio_batch_t *b;
+  int nthreads;
+  int labels; /* print the labels of the sets */
+  batch_deque_t *dq;
+
+  pthread_mutex_t lock; /* protects 'res' */
+  pthread_cond_t ready;
+  char **res; /* result of each family, NULL until it is computed */
+  size_t *len;
+} batch_t;
+
+typedef struct {
+  batch_t *bt;
+  int id;
+} batch_worker_t;
+
+/**
+ * Returns the next family for the thread 'w', or -1 if there is no more
+ */
+static int batch_take(batch_t *bt,int w)
+{
+  int i,k=-1;
+  batch_deque_t *d=bt->dq+w;
+
+  pthread_mutex_lock(&d->lock);
+  if(d->front<d->back) k=d->t[d->front++];
+  pthread_mutex_unlock(&d->lock);
+
+  for(i=1;k<0 && i<bt->nthreads;i++) {
+    d=bt->dq+(w+i)%bt->nthreads;
+    pthread_mutex_lock(&d->lock);
+    if(d->front<d->back) k=d->t[--d->back];
+    pthread_mutex_unlock(&d->lock);
+  }
+  return k;
+}
+
+/**
+ * Result of a family whose buffer cannot be written (out of memory): the
+ * writing thread prints the failure itself.
+ */
+static char batch_failed[1];
+
+/**
+ * Closes 'out', the stream of the buffer *buf (of *len bytes), and gives
+ * the buffer as the result of the family 'k' to the writing thread.
+ * 'out' may be NULL if it could not be opened.
+ */
+static void batch_done(batch_t *bt,int k,FILE *out,char **buf,size_t *len)
+{
+  char *r=batch_failed;
+  size_t l=0;
+  if(out!=NULL && fclose(out)==0) {
+    r=*buf;
+    l=*len;
+  } else
+    free(*buf);
+  pthread_mutex_lock(&bt->lock);
+  bt->res[k]=r;
+  bt->len[k]=l;
+  pthread_cond_broadcast(&bt->ready);
+  pthread_mutex_unlock(&bt->lock);
+}
+
+/**
+ * Work of a thread. The tables only grow, from one family to the next.
+ */
+static void *batch_worker(void *data)
+{
+  batch_worker_t *w=(batch_worker_t*)data;
+  batch_t *bt=w->bt;
+  overlap_ctx_t *c=overlap_ctx_create();
+  overlap_groups_t g;
+  ov_idx_t *lab=NULL;
+  ov_idx_t cap=0;
+  int k;
+
+  overlap_groups_init(&g);
+
+  while((k=batch_take(bt,w->id))>=0) {
+    family_t f;
+    FILE *out;
+    char *buf=NULL;
+    size_t len=0;
+    const char *err;
+    ov_idx_t i,q,nc;
+
+    if((out=open_memstream(&buf,&len))==NULL) {
+      batch_done(bt,k,NULL,&buf,&len);
+      continue;
+    }
+    err=NULL;
+    if(famio_batch_family(bt->b,k,&f)<0) 
+      err="out of memory";
+    else if(family_check_sets_ctx(c,&f)<0) 
+      err="invalid sets";
+    if(err) {
+      /* the family is not computed, the others are */
+      fprintf(out,"family %d: %s\n",k,err);
+      family_free(&f);
+      batch_done(bt,k,out,&buf,&len);
+      continue;
+    }
+    if(f.size+1>cap) {
+      cap=2*(f.size+1);
+      lab=(ov_idx_t*)realloc(lab,sizeof(ov_idx_t)*(size_t)cap);
+    }
+    nc=compute_overlap_groups_ctx(c,&f,&g);
+
+    fprintf(out,"family %d: %lld sets, %lld overlap components\n",k,
+	    (long long)f.size,(long long)nc);
+    if(bt->labels) {
+      /* labels in the input order, numbered in order of first occurence */
+      for(q=0;q<nc;q++)
+	for(i=g.off[q];i<g.off[q+1];i++)
+	  lab[g.sets[i]]=q+1;
+      for(i=0;i<f.size;i++)
+	fprintf(out,"%lld ",(long long)lab[i]);
+      fprintf(out,"\n");
+    }
+    family_free(&f);
+    batch_done(bt,k,out,&buf,&len);
+  }
+
+  overlap_groups_free(&g);
+  free(lab);
+  overlap_ctx_free(c);
+  return NULL;
+}
+
+/**
+ * Computes the overlap components of all the families of 'b' with 
+ * 'nthreads' threads, and writes them in 'out' in input order: one line 
+ * with the number of components by family, followed by the labels of 
+ * its sets if 'labels' is set. A family which cannot be computed (invalid
+ * sets, out of memory) only gets a line with the reason.
+ * Returns 0, or -1 if 'out' cannot be written.
+ */
+int batch_run(const famio_batch_t *b,int nthreads,int labels,FILE *out)
+{
+  batch_t bt;
+  batch_worker_t *w;
+  pthread_t *th;
+  int i,k,nt,ok=1;
+
+  if(nthreads<1) nthreads=1;
+  bt.b=b;
+  bt.nthreads=nthreads;
+  bt.labels=labels;
+  bt.dq=(batch_deque_t*)malloc(sizeof(batch_deque_t)*nthreads);
+  bt.res=(char**)calloc(b->nfam>0?b->nfam:1,sizeof(char*));
+  bt.len=(size_t*)calloc(b->nfam>0?b->nfam:1,sizeof(size_t));
+  pthread_mutex_init(&bt.lock,NULL);
+  pthread_cond_init(&bt.ready,NULL);
+  w=(batch_worker_t*)malloc(sizeof(batch_worker_t)*nthreads);
+  th=(pthread_t*)malloc(sizeof(pthread_t)*nthreads);
+
+  for(i=0;i<nthreads;i++) {
+    batch_deque_t *d=bt.dq+i;
+    pthread_mutex_init(&d->lock,NULL);
+    d->t=(int*)malloc(sizeof(int)*(b->nfam/nthreads+1));
+    d->front=d->back=0;
+    for(k=i;k<b->nfam;k+=nthreads)
+      d->t[d->back++]=k;
+  }
+
+  /* the deques of the threads which cannot be created are emptied by the 
+     others, or here if there is none */
+  for(i=0,nt=0;i<nthreads;i++) {
+    w[i].bt=&bt;
+    w[i].id=i;
+    if(pthread_create(&th[nt],NULL,batch_worker,&w[i])==0)
+      nt++;
+  }
+  if(nt==0)
+    batch_worker(&w[0]);
+
+  for(k=0;k<b->nfam;k++) {
+    char *r;
+    pthread_mutex_lock(&bt.lock);
+    while(bt.res[k]==NULL)
+      pthread_cond_wait(&bt.ready,&bt.lock);
+    r=bt.res[k];
+    pthread_mutex_unlock(&bt.lock);
+    if(r==batch_failed) {
+      if(ok && fprintf(out,"family %d: out of memory\n",k)<0) 
+	ok=0;
+    } else {
+      if(ok && fwrite(r,1,bt.len[k],out)!=bt.len[k]) 
+	ok=0;
+      free(r);
+    }
+  }
+
+  for(i=0;i<nt;i++)
+    pthread_join(th[i],NULL);
+  for(i=0;i<nthreads;i++) {
+    pthread_mutex_destroy(&bt.dq[i].lock);
+    free(bt.dq[i].t);
+  }
+  pthread_mutex_destroy(&bt.lock);
+  pthread_cond_destroy(&bt.ready);
+  free(bt.dq);
+  free(bt.res);
+  free(bt.len);
+  free(w);
+  free(th);
+  return ok?0:-1;
+}
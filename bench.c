@@ -0,0 +1,311 @@
+/*
+ *   This source file is part of program computing set overlap classes 
+ *   in linear time.
+ *   Copyright (C) 2007  Michael Rao
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "overlap.h"
+#include "gen.h"
+#include "cc.h"
+#include "famio.h"
+
+/*
+ * Benchmark of the phases of the computation.
+ * For every input (generated by family_gen, or read in a file), and every
+ * repetition, the family is rebuilt from a copy in its original order, 
+ * then compute_max, the two graph builders with their connected 
+ * components, and compute_overlap_components are timed.
+ * One line (CSV) or one object (JSON) is printed per repetition.
+ * With a library compiled with -DOVERLAP_STATS ('make STATS=-DOVERLAP_STATS'),
+ * the counters of overlap_stats_t are printed too.
+ */
+
+typedef struct {
+  int reps,warmup,nthreads;
+  int json;
+  int seed;
+} bench_opt_t;
+
+/**
+ * An input: its description and a copy of its sets in CSR form
+ */
+typedef struct {
+  char name[256];
+  int grnd,degree,seed;
+  float dens;
+  ov_idx_t size,nelms;
+  ov_idx_t *offsets;
+  int *elms;
+} bench_input_t;
+
+static int nbr_lines=0;
+
+/* counters of overlap_stats_t, printed if overlap_stats_enabled */
+#define NBR_COUNTERS 9
+static const char *counter_name[NBR_COUNTERS]={
+  "refine","xcg","classes","fct_test","am_advance",
+  "quintuples","quintuples_qr","edges","edges_sorted"
+};
+
+static long long counter(const overlap_stats_t *st,int c)
+{
+  switch(c) {
+  case 0: return st->refine;
+  case 1: return st->xcg;
+  case 2: return st->classes;
+  case 3: return st->fct_test;
+  case 4: return st->am_advance;
+  case 5: return st->quintuples;
+  case 6: return st->quintuples_qr;
+  case 7: return st->edges;
+  default: return st->edges_sorted;
+  }
+}
+
+static void input_copy(bench_input_t *in,const family_t *f)
+{
+  ov_idx_t i;
+  in->grnd=f->grnd_size;
+  in->size=f->size;
+  in->nelms=f->elms_size;
+  in->offsets=(ov_idx_t*)malloc(sizeof(ov_idx_t)*(size_t)(f->size+1));
+  in->elms=(int*)malloc(sizeof(int)*(size_t)(f->elms_size>0?f->elms_size:1));
+  in->offsets[0]=0;
+  for(i=0;i<f->size;i++) {
+    memcpy(in->elms+in->offsets[i],family_set(f,i),sizeof(int)*(size_t)f->sets.size[i]);
+    in->offsets[i+1]=in->offsets[i]+f->sets.size[i];
+  }
+}
+
+static void print_result(const bench_opt_t *o,const bench_input_t *in,int rep,
+			 const overlap_stats_t *st,double uf,double total)
+{
+  int p;
+  if(o->json) {
+    printf("%s{\"input\":\"%s\",\"grnd\":%d,\"degree\":%d,\"dens\":%g,"
+	   "\"seed\":%d,\"sets\":%lld,\"sum\":%lld,\"rep\":%d",
+	   nbr_lines?",\n ":"[\n ",in->name,in->grnd,in->degree,in->dens,
+	   in->seed,(long long)in->size,(long long)in->nelms,rep);
+    for(p=0;p<PH_NBR;p++)
+      printf(",\"%s\":%.6f",overlap_phase_name[p],st->time[p]);
+    printf(",\"uf_engine\":%.6f,\"total\":%.6f",uf,total);
+    if(overlap_stats_enabled) {
+      for(p=0;p<NBR_COUNTERS;p++)
+	printf(",\"%s\":%lld",counter_name[p],counter(st,p));
+      for(p=0;p<PH_NBR;p++)
+	printf(",\"allocs_%s\":%lld,\"bytes_%s\":%lld",overlap_phase_name[p],
+	       st->allocs[p],overlap_phase_name[p],st->bytes[p]);
+    }
+    printf("}");
+  } else {
+    if(nbr_lines==0) {
+      printf("input,grnd,degree,dens,seed,sets,sum,rep");
+      for(p=0;p<PH_NBR;p++)
+	printf(",%s",overlap_phase_name[p]);
+      printf(",uf_engine,total");
+      if(overlap_stats_enabled) {
+	for(p=0;p<NBR_COUNTERS;p++)
+	  printf(",%s",counter_name[p]);
+	for(p=0;p<PH_NBR;p++)
+	  printf(",allocs_%s,bytes_%s",overlap_phase_name[p],overlap_phase_name[p]);
+      }
+      printf("\n");
+    }
+    printf("%s,%d,%d,%g,%d,%lld,%lld,%d",in->name,in->grnd,in->degree,in->dens,
+	   in->seed,(long long)in->size,(long long)in->nelms,rep);
+    for(p=0;p<PH_NBR;p++)
+      printf(",%.6f",st->time[p]);
+    printf(",%.6f,%.6f",uf,total);
+    if(overlap_stats_enabled) {
+      for(p=0;p<NBR_COUNTERS;p++)
+	printf(",%lld",counter(st,p));
+      for(p=0;p<PH_NBR;p++)
+	printf(",%lld,%lld",st->allocs[p],st->bytes[p]);
+    }
+    printf("\n");
+  }
+  nbr_lines++;
+}
+
+/**
+ * Runs all the repetitions on an input
+ */
+static void bench_input(const bench_opt_t *o,const bench_input_t *in)
+{
+  int r;
+  ov_idx_t *cc=(ov_idx_t*)malloc(sizeof(ov_idx_t)*(size_t)(in->size>0?in->size:1));
+  /* one context for all the runs: after the warmup, only the results are
+     allocated */
+  overlap_ctx_t *c=overlap_ctx_create();
+
+  for(r=-o->warmup;r<o->reps;r++) {
+    family_t f;
+    graph_t g;
+    overlap_stats_t st;
+    double t,t0,uf;
+
+    memset(&st,0,sizeof(st));
+    family_create_ctx(c,&f,in->grnd);
+    family_add_sets_bulk(&f,in->size,in->offsets,in->elms);
+    f.stats=&st;
+
+    t0=overlap_time();
+    compute_max_ctx(c,&f);
+
+    graph_dahlhaus_create_ctx(c,&g,&f);
+    t=overlap_time();
+    graph_connected_components_parallel(&g,cc,o->nthreads);
+    st.time[PH_CC]+=overlap_time()-t;
+    graph_free(&g);
+
+    graph_subgraph_overlap_create_ctx(c,&g,&f);
+    t=overlap_time();
+    graph_connected_components_parallel(&g,cc,o->nthreads);
+    st.time[PH_CC]+=overlap_time()-t;
+    graph_free(&g);
+    t=overlap_time();
+    family_free(&f);
+
+    /* the engine without graph, not profiled */
+    family_create_ctx(c,&f,in->grnd);
+    family_add_sets_bulk(&f,in->size,in->offsets,in->elms);
+    uf=overlap_time();
+    compute_overlap_components_ctx(c,&f,cc);
+    uf=overlap_time()-uf;
+    family_free(&f);
+
+    if(r>=0) 
+      print_result(o,in,r,&st,uf,t-t0);
+  }
+  overlap_ctx_free(c);
+  free(cc);
+}
+
+static void usage(const char *prg)
+{
+  printf("usage: '%s [options] [file...]'\n"
+	 "Times every phase on generated families (sweep over the lists\n"
+	 "below), or on the families in the files.\n"
+	 "options:\n"
+	 "  -g n,n,... : sizes of the ground set (default 10000,100000)\n"
+	 "  -d n,n,... : degrees (default 30)\n"
+	 "  -p x,x,... : densities (default 0.05)\n"
+	 "  -s seed    : seed of the generator (default 1)\n"
+	 "  -r n       : number of repetitions (default 3)\n"
+	 "  -w n       : number of warmup runs (default 1)\n"
+	 "  -j n       : threads for the connected components (default 1)\n"
+	 "  -json      : JSON output (default CSV)\n",prg);
+  exit(1);
+}
+
+/**
+ * Split a list "a,b,c" into 't' (at most 'max' values)
+ */
+static int parse_list(char *s,double *t,int max)
+{
+  int n=0;
+  char *p=strtok(s,",");
+  while(p && n<max) {
+    t[n++]=atof(p);
+    p=strtok(NULL,",");
+  }
+  return n;
+}
+
+int main(int argc, char **argv)
+{
+  bench_opt_t o;
+  double grnd[64]={10000,100000},deg[64]={30},dens[64]={0.05};
+  int ngrnd=2,ndeg=1,ndens=1;
+  int a,i,j,k;
+  int nfiles=0;
+
+  o.reps=3;
+  o.warmup=1;
+  o.nthreads=1;
+  o.json=0;
+  o.seed=1;
+
+  for(a=1;a<argc && argv[a][0]=='-' && argv[a][1];a++) {
+    if(strcmp(argv[a],"-json")==0) 
+      o.json=1;
+    else if(a+1>=argc)
+      usage(argv[0]);
+    else if(strcmp(argv[a],"-g")==0) 
+      ngrnd=parse_list(argv[++a],grnd,64);
+    else if(strcmp(argv[a],"-d")==0) 
+      ndeg=parse_list(argv[++a],deg,64);
+    else if(strcmp(argv[a],"-p")==0) 
+      ndens=parse_list(argv[++a],dens,64);
+    else if(strcmp(argv[a],"-s")==0) 
+      o.seed=atoi(argv[++a]);
+    else if(strcmp(argv[a],"-r")==0) 
+      o.reps=atoi(argv[++a]);
+    else if(strcmp(argv[a],"-w")==0) 
+      o.warmup=atoi(argv[++a]);
+    else if(strcmp(argv[a],"-j")==0) 
+      o.nthreads=atoi(argv[++a]);
+    else
+      usage(argv[0]);
+  }
+  nfiles=argc-a;
+
+  if(nfiles) {
+    for(;a<argc;a++) {
+      bench_input_t in;
+      family_t f;
+      if(family_read_txt(&f,argv[a],o.nthreads)<0) {
+	perror("cannot read file\n");
+	exit(1);
+      }
+      strncpy(in.name,argv[a],sizeof(in.name)-1);
+      in.name[sizeof(in.name)-1]=0;
+      in.degree=in.seed=0;
+      in.dens=0;
+      input_copy(&in,&f);
+      family_free(&f);
+      bench_input(&o,&in);
+      free(in.offsets);
+      free(in.elms);
+    }
+  } else {
+    for(i=0;i<ngrnd;i++)
+      for(j=0;j<ndeg;j++)
+	for(k=0;k<ndens;k++) {
+	  bench_input_t in;
+	  family_t f;
+	  strcpy(in.name,"gen");
+	  in.degree=deg[j];
+	  in.dens=dens[k];
+	  in.seed=o.seed;
+	  family_create(&f,grnd[i]);
+	  family_gen(&f,grnd[i],in.degree,in.dens,in.seed);
+	  input_copy(&in,&f);
+	  family_free(&f);
+	  bench_input(&o,&in);
+	  free(in.offsets);
+	  free(in.elms);
+	}
+  }
+
+  if(o.json)
+    printf(nbr_lines?"\n]\n":"[]\n");
+
+  return 0;
+}
@@ -0,0 +1,240 @@
+/*
+ *   This source file is part of program computing set overlap classes 
+ *   in linear time.
+ *   Copyright (C) 2007  Michael Rao
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdlib.h>
+#include <assert.h>
+#include <pthread.h>
+#include "blocks.h"
+#include "cc.h"
+
+/*
+ * Overlap components by independent blocks.
+ * Two sets are in the same overlap component only if they are linked by
+ * a chain of sets, each one meeting the next, so the components of 
+ * different blocks (see family_blocks_parallel) are computed separately.
+ * Every block becomes a view with local elements 0..k-1, and the blocks 
+ * are computed by a pool of threads, each one with its own context. 
+ * The threads take the blocks by decreasing number of elements, so that 
+ * a large block does not come last.
+ */
+
+/**
+ * Shared data of the threads
+ */
+typedef struct {
+  const family_t *f;
+  ov_idx_t nb; /* number of blocks with sets */
+  ov_idx_t *boff; /* the sets of the block b are bsets[boff[b]..boff[b+1]-1] */
+  ov_idx_t *bsets; /* positions in f->sets */
+  ov_idx_t *order; /* the blocks, by decreasing number of elements */
+  ov_idx_t next; /* next entry of 'order' to take */
+  ov_idx_t *t; /* component of every set, numbered in its block */
+  ov_idx_t *nc; /* number of components of every block */
+  int *loc; /* local indice of every element in its block */
+  int err; /* set if a block could not be computed */
+} blocks_t;
+
+/**
+ * Work of a thread. The tables only grow, from one block to the next.
+ */
+static void *blocks_worker(void *data)
+{
+  blocks_t *b=(blocks_t*)data;
+  const family_t *f=b->f;
+  overlap_ctx_t *c=overlap_ctx_create();
+  ov_idx_t *off=NULL,*lt=NULL;
+  int *elms=NULL;
+  ov_idx_t off_cap=0,elms_cap=0;
+  ov_idx_t i;
+
+  while((i=__sync_fetch_and_add(&b->next,1))<b->nb) {
+    ov_idx_t k=b->order[i];
+    ov_idx_t *s=b->bsets+b->boff[k];
+    ov_idx_t ns=b->boff[k+1]-b->boff[k];
+    ov_idx_t j,m=0;
+    int l,nl=0;
+    family_t sub;
+
+    if(ns==1) { /* nothing to compute */
+      b->t[s[0]]=1;
+      b->nc[k]=1;
+      continue;
+    }
+
+    /* the block with local elements, in CSR form */
+    for(j=0;j<ns;j++)
+      m+=f->sets.size[s[j]];
+    if(ns+1>off_cap) {
+      off_cap=2*(ns+1);
+      off=(ov_idx_t*)realloc(off,sizeof(ov_idx_t)*(size_t)off_cap);
+      lt=(ov_idx_t*)realloc(lt,sizeof(ov_idx_t)*(size_t)off_cap);
+    }
+    if(m>elms_cap) {
+      elms_cap=2*m;
+      elms=(int*)realloc(elms,sizeof(int)*(size_t)elms_cap);
+    }
+    off[0]=0;
+    for(j=0;j<ns;j++) {
+      const int *set=family_set(f,s[j]);
+      int *dst=elms+off[j];
+      for(l=0;l<f->sets.size[s[j]];l++) {
+	if(b->loc[set[l]]<0) b->loc[set[l]]=nl++;
+	dst[l]=b->loc[set[l]];
+      }
+      off[j+1]=off[j]+f->sets.size[s[j]];
+    }
+
+    if(family_view(&sub,nl,ns,off,elms)<0) {
+      b->err=1;
+      break;
+    }
+    b->nc[k]=compute_overlap_components_ctx(c,&sub,lt);
+    for(j=0;j<ns;j++)
+      b->t[s[sub.sets.id[j]]]=lt[j];
+    family_free(&sub);
+  }
+
+  free(off);
+  free(lt);
+  free(elms);
+  overlap_ctx_free(c);
+  return NULL;
+}
+
+/**
+ * Computes the overlap components of 'f' block by block, with 'nthreads'
+ * threads. 'f' is not changed.
+ * 't' is indiced by the identifiers of the sets (f->sets.id), components
+ * are numbered from 1 in the order of their smallest identifier.
+ * '*nblocks' (if not NULL) is set to the number of blocks with sets.
+ * Returns the number of components, or -1 if memory is exhausted.
+ * Time: O(f->grnd_size + \sum_i f->set[i].size)
+ */
+ov_idx_t blocks_components(const family_t *f,ov_idx_t *t,int nthreads,ov_idx_t *nblocks)
+{
+  blocks_t b;
+  ov_idx_t n=f->size,g=f->grnd_size>0?f->grnd_size:1;
+  ov_idx_t *eb=(ov_idx_t*)malloc(sizeof(ov_idx_t)*(size_t)g);
+  ov_idx_t *sb=(ov_idx_t*)malloc(sizeof(ov_idx_t)*(size_t)(n>0?n:1));
+  ov_idx_t *cnt,*num;
+  pthread_t *th;
+  int nt;
+  ov_idx_t i,k,ne,nc,p=0;
+
+  if(nthreads<1) nthreads=1;
+
+  /* the block of every set; blocks without sets are dropped */
+  ne=family_blocks_parallel(f,eb,nthreads);
+  cnt=(ov_idx_t*)calloc((size_t)ne+2,sizeof(ov_idx_t));
+  for(i=0;i<n;i++) {
+    sb[i]=eb[family_set(f,i)[0]];
+    cnt[sb[i]]++;
+  }
+  for(k=1,b.nb=0;k<=ne;k++)
+    cnt[k]=cnt[k]?b.nb++:-1;
+  for(i=0;i<n;i++)
+    sb[i]=cnt[sb[i]];
+  free(cnt);
+  free(eb);
+
+  /* the sets of every block (counting sort) */
+  b.f=f;
+  b.boff=(ov_idx_t*)calloc((size_t)b.nb+1,sizeof(ov_idx_t));
+  b.bsets=(ov_idx_t*)malloc(sizeof(ov_idx_t)*(size_t)(n>0?n:1));
+  for(i=0;i<n;i++)
+    b.boff[sb[i]+1]++;
+  for(k=0;k<b.nb;k++)
+    b.boff[k+1]+=b.boff[k];
+  for(i=0;i<n;i++)
+    b.bsets[b.boff[sb[i]]++]=i;
+  for(k=b.nb;k>0;k--)
+    b.boff[k]=b.boff[k-1];
+  b.boff[0]=0;
+
+  /* blocks by decreasing number of elements (counting sort) */
+  {
+    ov_idx_t *w=(ov_idx_t*)calloc((size_t)b.nb+1,sizeof(ov_idx_t));
+    ov_idx_t *start,wmax=0;
+    for(i=0;i<n;i++)
+      w[sb[i]]+=f->sets.size[i];
+    for(k=0;k<b.nb;k++)
+      if(w[k]>wmax) wmax=w[k];
+    start=(ov_idx_t*)calloc((size_t)wmax+2,sizeof(ov_idx_t));
+    for(k=0;k<b.nb;k++)
+      start[wmax-w[k]+1]++;
+    for(i=0;i<=wmax;i++)
+      start[i+1]+=start[i];
+    b.order=(ov_idx_t*)malloc(sizeof(ov_idx_t)*(size_t)(b.nb+1));
+    for(k=0;k<b.nb;k++)
+      b.order[start[wmax-w[k]]++]=k;
+    free(start);
+    free(w);
+  }
+
+  b.next=0;
+  b.err=0;
+  b.t=(ov_idx_t*)malloc(sizeof(ov_idx_t)*(size_t)(n>0?n:1));
+  b.nc=(ov_idx_t*)malloc(sizeof(ov_idx_t)*(size_t)(b.nb+1));
+  b.loc=(int*)malloc(sizeof(int)*(size_t)g);
+  for(i=0;i<f->grnd_size;i++)
+    b.loc[i]=-1;
+
+  /* the threads share the blocks: the ones which cannot be created are 
+     just not joined, the others take their blocks */
+  th=(pthread_t*)malloc(sizeof(pthread_t)*nthreads);
+  for(k=1,nt=1;k<nthreads;k++)
+    if(pthread_create(&th[nt],NULL,blocks_worker,&b)==0) 
+      nt++;
+  blocks_worker(&b);
+  for(k=1;k<nt;k++)
+    pthread_join(th[k],NULL);
+  free(th);
+
+  /* merge: the components of the block k follow the ones of the blocks
+     before it, then they are numbered by smallest identifier */
+  if(b.err) 
+    nc=-1;
+  else {
+    for(k=0,nc=0;k<b.nb;k++) {
+      ov_idx_t c=b.nc[k];
+      b.nc[k]=nc;
+      nc+=c;
+    }
+    for(i=0;i<n;i++)
+      t[f->sets.id[i]]=b.nc[sb[i]]+b.t[i];
+    num=(ov_idx_t*)calloc((size_t)nc+1,sizeof(ov_idx_t));
+    for(i=0;i<n;i++) {
+      if(num[t[i]]==0) num[t[i]]=++p;
+      t[i]=num[t[i]];
+    }
+    assert(p==nc);
+    free(num);
+  }
+
+  if(nblocks) *nblocks=b.nb;
+  free(b.boff);
+  free(b.bsets);
+  free(b.order);
+  free(b.t);
+  free(b.nc);
+  free(b.loc);
+  free(sb);
+  return nc;
+}
@@ -0,0 +1,276 @@
+/*
+ *   This source file is part of program computing set overlap classes 
+ *   in linear time.
+ *   Copyright (C) 2007  Michael Rao
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdlib.h>
+#include <pthread.h>
+#include "cc.h"
+
+/*
+ * Parallel connected components (hook and compress).
+ * The threads share a parent table 'p' (p[i]==i for a root). 
+ * A root is always hooked under a smaller root, with a compare-and-swap, 
+ * so the root of a component is its smallest vertex. The components are then
+ * numbered from 1 in the order of their smallest vertex, as 
+ * graph_connected_components does: the labels are the same.
+ * The same phases give the blocks of a family: the vertices are then the
+ * elements, and every set joins its elements.
+ */
+
+/**
+ * Work of one thread
+ */
+typedef struct {
+  const graph_t *g;
+  const family_t *f;
+  ov_idx_t *p;
+  ov_idx_t *t;
+  ov_idx_t begin,end; /* vertices of the thread */
+  ov_idx_t nroots; /* number of roots in [begin,end[, then first label */
+} cc_thread_t;
+
+/**
+ * Returns the root of 'i'. 
+ * Path halving is safe: p[i] is only replaced by one of its ancestors.
+ * Accesses are relaxed atomics, since other threads hook roots meanwhile.
+ */
+static ov_idx_t cc_find(ov_idx_t *p,ov_idx_t i)
+{
+  ov_idx_t q;
+  while((q=__atomic_load_n(&p[i],__ATOMIC_RELAXED))!=i) {
+    ov_idx_t q2=__atomic_load_n(&p[q],__ATOMIC_RELAXED);
+    if(q2!=q) 
+      __atomic_store_n(&p[i],q2,__ATOMIC_RELAXED);
+    i=q2;
+  }
+  return i;
+}
+
+/**
+ * Join the components of 'u' and 'v'
+ */
+static void cc_union(ov_idx_t *p,ov_idx_t u,ov_idx_t v)
+{
+  while(1) {
+    u=cc_find(p,u);
+    v=cc_find(p,v);
+    if(u==v) break;
+    if(u<v) {
+      ov_idx_t t=u; u=v; v=t;
+    }
+    /* hook the greater root u under v */
+    if(__sync_bool_compare_and_swap(&p[u],u,v)) break;
+  }
+}
+
+static void *cc_hook(void *data)
+{
+  cc_thread_t *d=(cc_thread_t*)data;
+  const graph_t *g=d->g;
+  ov_idx_t i,j;
+
+  for(i=d->begin;i<d->end;i++)
+    for(j=g->off[i];j<g->off[i+1];j++)
+      if(g->adj[j]>i) /* each edge once */
+	cc_union(d->p,i,g->adj[j]);
+  return NULL;
+}
+
+/**
+ * Join the elements of the sets [begin,end[ of the family
+ */
+static void *cc_hook_sets(void *data)
+{
+  cc_thread_t *d=(cc_thread_t*)data;
+  const family_t *f=d->f;
+  ov_idx_t i;
+  int j;
+
+  for(i=d->begin;i<d->end;i++) {
+    const int *set=family_set(f,i);
+    for(j=1;j<f->sets.size[i];j++)
+      cc_union(d->p,set[0],set[j]);
+  }
+  return NULL;
+}
+
+static void *cc_compress(void *data)
+{
+  cc_thread_t *d=(cc_thread_t*)data;
+  ov_idx_t i;
+
+  d->nroots=0;
+  for(i=d->begin;i<d->end;i++) {
+    d->t[i]=cc_find(d->p,i);
+    if(d->t[i]==i) d->nroots++;
+  }
+  return NULL;
+}
+
+static void *cc_label(void *data)
+{
+  cc_thread_t *d=(cc_thread_t*)data;
+  ov_idx_t i,l=d->nroots;
+
+  /* roots of the range get their label, in increasing order */
+  for(i=d->begin;i<d->end;i++)
+    if(d->t[i]==i) 
+      d->p[i]=++l;
+  return NULL;
+}
+
+static void *cc_label2(void *data)
+{
+  cc_thread_t *d=(cc_thread_t*)data;
+  ov_idx_t i;
+  for(i=d->begin;i<d->end;i++)
+    d->t[i]=d->p[d->t[i]];
+  return NULL;
+}
+
+/**
+ * Run 'fct' on every thread, and wait for them.
+ * The slices of the threads which cannot be created are run by the caller.
+ */
+static void cc_run(cc_thread_t *d,int nthreads,void *(*fct)(void *))
+{
+  pthread_t *th=(pthread_t*)malloc(sizeof(pthread_t)*nthreads);
+  int *run=(int*)malloc(sizeof(int)*nthreads);
+  int k;
+  for(k=1;k<nthreads;k++)
+    run[k]=pthread_create(&th[k],NULL,fct,&d[k])==0;
+  fct(&d[0]);
+  for(k=1;k<nthreads;k++) {
+    if(run[k]) 
+      pthread_join(th[k],NULL);
+    else 
+      fct(&d[k]);
+  }
+  free(run);
+  free(th);
+}
+
+/**
+ * Computes the connected components of 'g' with 'nthreads' threads, 
+ * and put them into 't' (same labels as graph_connected_components).
+ * Vertices are split between the threads according to their degrees.
+ * Returns the number of connected components
+ */
+ov_idx_t graph_connected_components_parallel(const graph_t *g,ov_idx_t *t,int nthreads)
+{
+  cc_thread_t *d;
+  ov_idx_t *p;
+  ov_idx_t i,nc;
+  int k;
+
+  if(nthreads<=1 || g->n<2*nthreads) 
+    return graph_connected_components(g,t);
+
+  p=(ov_idx_t*)malloc(sizeof(ov_idx_t)*g->n);
+  d=(cc_thread_t*)malloc(sizeof(cc_thread_t)*nthreads);
+  for(i=0;i<g->n;i++)
+    p[i]=i;
+
+  /* the thread k gets about (off[n]+n)/nthreads half-edges and vertices */
+  for(k=0,i=0;k<nthreads;k++) {
+    long long lim=((long long)(g->off[g->n]+g->n)*(k+1))/nthreads;
+    d[k].g=g;
+    d[k].f=NULL;
+    d[k].p=p;
+    d[k].t=t;
+    d[k].begin=i;
+    while(i<g->n && (long long)g->off[i]+i<lim) i++;
+    if(k==nthreads-1) i=g->n;
+    d[k].end=i;
+  }
+
+  cc_run(d,nthreads,cc_hook);
+  cc_run(d,nthreads,cc_compress);
+  for(k=0,nc=0;k<nthreads;k++) {
+    ov_idx_t r=d[k].nroots;
+    d[k].nroots=nc;
+    nc+=r;
+  }
+  cc_run(d,nthreads,cc_label);
+  cc_run(d,nthreads,cc_label2);
+
+  free(d);
+  free(p);
+  return nc;
+}
+
+/**
+ * Computes the blocks of 'f' with 'nthreads' threads: two elements are 
+ * in the same block if they are linked by a chain of sets, each one 
+ * meeting the next. Thus two sets of different blocks are in different 
+ * overlap components.
+ * 't' has f->grnd_size entries, the blocks are numbered from 1 in the 
+ * order of their smallest element (an element of no set is a block).
+ * Sets are split between the threads according to their sizes.
+ * Returns the number of blocks.
+ * Time: O(f->grnd_size + \sum_i f->set[i].size) (times the inverse of
+ * Ackermann's function)
+ */
+ov_idx_t family_blocks_parallel(const family_t *f,ov_idx_t *t,int nthreads)
+{
+  cc_thread_t *d;
+  ov_idx_t *p;
+  ov_idx_t i,nc,n=f->grnd_size;
+  long long s=0;
+  int k;
+
+  if(nthreads<1) nthreads=1;
+  p=(ov_idx_t*)malloc(sizeof(ov_idx_t)*(n>0?n:1));
+  d=(cc_thread_t*)malloc(sizeof(cc_thread_t)*nthreads);
+  for(i=0;i<n;i++)
+    p[i]=i;
+
+  /* the thread k gets about elms_size/nthreads elements of the sets */
+  for(k=0,i=0;k<nthreads;k++) {
+    long long lim=((long long)f->elms_size*(k+1))/nthreads;
+    d[k].g=NULL;
+    d[k].f=f;
+    d[k].p=p;
+    d[k].t=t;
+    d[k].begin=i;
+    while(i<f->size && s<lim) s+=f->sets.size[i++];
+    if(k==nthreads-1) i=f->size;
+    d[k].end=i;
+  }
+  cc_run(d,nthreads,cc_hook_sets);
+
+  /* then the elements are split evenly */
+  for(k=0;k<nthreads;k++) {
+    d[k].begin=(ov_idx_t)(((long long)n*k)/nthreads);
+    d[k].end=(ov_idx_t)(((long long)n*(k+1))/nthreads);
+  }
+  cc_run(d,nthreads,cc_compress);
+  for(k=0,nc=0;k<nthreads;k++) {
+    ov_idx_t r=d[k].nroots;
+    d[k].nroots=nc;
+    nc+=r;
+  }
+  cc_run(d,nthreads,cc_label);
+  cc_run(d,nthreads,cc_label2);
+
+  free(d);
+  free(p);
+  return nc;
+}
@@ -0,0 +1,28 @@
+/*
+ *   This source file is part of program computing set overlap classes 
+ *   in linear time.
+ *   Copyright (C) 2007  Michael Rao
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _CC_H_
+#define _CC_H_
+
+#include "overlap.h"
+
+extern ov_idx_t graph_connected_components_parallel(const graph_t *g,ov_idx_t *t,int nthreads);
+extern ov_idx_t family_blocks_parallel(const family_t *f,ov_idx_t *t,int nthreads);
+
+#endif
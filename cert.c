@@ -0,0 +1,106 @@
+/*
+ *   This source file is part of program computing set overlap classes 
+ *   in linear time.
+ *   Copyright (C) 2007  Michael Rao
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <stdlib.h>
+#include "cert.h"
+#include "uf.h"
+
+/**
+ * Checks the certificate of the overlap components given by 
+ * compute_overlap_certificates: 't' numbers the components 1..nc, 
+ * and 'cert' has f->size-nc entries. The certificate is valid if
+ *  - the sets of every entry are in the same component, and the entries
+ *    make a forest with one tree by component,
+ *  - the witnesses of every entry are in the right sets.
+ * Thus every component is connected in the overlap graph. (That two
+ * components do not overlap is not certified.)
+ * The membership tests are grouped by set: a set is marked once for all
+ * the entries where it appears.
+ * Returns 1 if the certificate is valid, 0 otherwise.
+ * Time: O(f->grnd_size + f->size + \sum_i f->set[i].size)
+ */
+int overlap_cert_check(const family_t *f,const ov_idx_t *t,ov_idx_t nc,const overlap_cert_t *cert)
+{
+  ov_idx_t i,j,n=f->size,m=f->size-nc;
+  ov_idx_t *cnt,*ent;
+  int *mark;
+  uf_t u;
+  int ok=(nc>=0 && m>=0);
+
+  if(!ok) return 0;
+
+  /* the components, and the forest */
+  cnt=(ov_idx_t*)calloc((size_t)n+2,sizeof(ov_idx_t));
+  for(i=0;i<n && ok;i++) {
+    if(t[i]<1 || t[i]>nc) ok=0;
+    else cnt[t[i]]=1;
+  }
+  for(i=1;i<=nc && ok;i++)
+    if(cnt[i]==0) ok=0;
+  uf_create(&u,n);
+  for(i=0;i<m && ok;i++) {
+    const overlap_cert_t *x=cert+i;
+    if(x->a<0 || x->a>=n || x->b<0 || x->b>=n || t[x->a]!=t[x->b]
+       || x->in<0 || x->in>=f->grnd_size || x->ab<0 || x->ab>=f->grnd_size
+       || x->ba<0 || x->ba>=f->grnd_size || !uf_union(&u,x->a,x->b))
+      ok=0;
+  }
+  uf_free(&u);
+  if(!ok) {
+    free(cnt);
+    return 0;
+  }
+
+  /* the entries by set (both ends), in 'ent' */
+  for(i=0;i<=n+1;i++)
+    cnt[i]=0;
+  for(i=0;i<m;i++) {
+    cnt[cert[i].a+2]++;
+    cnt[cert[i].b+2]++;
+  }
+  for(i=2;i<=n+1;i++)
+    cnt[i]+=cnt[i-1];
+  ent=(ov_idx_t*)malloc(sizeof(ov_idx_t)*(size_t)(2*m>0?2*m:1));
+  for(i=0;i<m;i++) {
+    ent[cnt[cert[i].a+1]++]=i;
+    ent[cnt[cert[i].b+1]++]=i;
+  }
+
+  /* membership tests */
+  mark=(int*)calloc((size_t)(f->grnd_size>0?f->grnd_size:1),sizeof(int));
+  for(i=0;i<n && ok;i++) {
+    const int *set=family_set(f,i);
+    int k;
+    if(cnt[i]==cnt[i+1]) continue;
+    for(k=0;k<f->sets.size[i];k++)
+      mark[set[k]]=1;
+    for(j=cnt[i];j<cnt[i+1];j++) {
+      const overlap_cert_t *x=cert+ent[j];
+      if(!mark[x->in]) ok=0;
+      if(x->a==i && (!mark[x->ab] || mark[x->ba])) ok=0;
+      if(x->b==i && (!mark[x->ba] || mark[x->ab])) ok=0;
+    }
+    for(k=0;k<f->sets.size[i];k++)
+      mark[set[k]]=0;
+  }
+
+  free(mark);
+  free(ent);
+  free(cnt);
+  return ok;
+}
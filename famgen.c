@@ -0,0 +1,73 @@
+/*
+ *   This source file is part of program computing set overlap classes 
+ *   in linear time.
+ *   Copyright (C) 2007  Michael Rao
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "overlap.h"
+#include "gen.h"
+
+/**
+ * Generates a family with the parallel generator (family_gen_write), and
+ * writes it in a file without keeping it in memory
+ */
+int main(int argc, char **argv)
+{
+  int nthreads=1,binary=0,degree=30;
+  float dens=0.05;
+  long long nsets,nelms;
+  char *prg=argv[0];
+
+  while(argc>1 && argv[1][0]=='-' && argv[1][1]) {
+    if(strcmp(argv[1],"-j")==0 && argc>2) {
+      nthreads=atoi(argv[2]);
+      argc--; argv++;
+    } else if(strcmp(argv[1],"-d")==0 && argc>2) {
+      degree=atoi(argv[2]);
+      argc--; argv++;
+    } else if(strcmp(argv[1],"-p")==0 && argc>2) {
+      dens=atof(argv[2]);
+      argc--; argv++;
+    } else if(strcmp(argv[1],"-b")==0) {
+      binary=1;
+    } else
+      argc=0;
+    argc--; argv++;
+  }
+
+  if(argc!=4) {
+    printf("usage: '%s [options] size_grnd seed out' ('-' is the standard output)\n"
+	   "options:\n"
+	   "  -j n : use n threads (the family does not depend on n)\n"
+	   "  -b   : write the binary format (see txt2bin)\n"
+	   "  -d n : at most n children by node of the inclusion tree (30)\n"
+	   "  -p x : x*d^2 sets by node with d children (0.05)\n",prg);
+    exit(1);
+  }
+
+  if(family_gen_write(argv[3],binary,atoi(argv[1]),degree,dens,atoi(argv[2]),
+		      nthreads,&nsets,&nelms)<0) {
+    perror("cannot write file\n");
+    exit(1);
+  }
+
+  if(strcmp(argv[3],"-")!=0)
+    printf("++ %lld sets, ground set %d, \\sum_i |X_i| = %lld ++\n",
+	   nsets,atoi(argv[1]),nelms);
+  return 0;
+}
@@ -0,0 +1,766 @@
+/*
+ *   This source file is part of program computing set overlap classes 
+ *   in linear time.
+ *   Copyright (C) 2007  Michael Rao
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <pthread.h>
+#include "famio.h"
+
+/*
+ * Text format: integers separated by white spaces, every set is ended by
+ * a negative integer (-1). The file is read in one pass, by large blocks,
+ * and parsed by hand. The ground set is {0..max}, where max is the largest
+ * element read: we suppose that every element < max is used.
+ * In a batch file (see famio_read_batch), a token <= -2 also ends the 
+ * current family. family_read_txt takes it as a -1.
+ * family_read_txt_sparse accepts any 64-bit elements, and renumbers them
+ * while parsing (see remap_t): the ground set is then the set of the 
+ * elements used.
+ */
+
+#define FAMIO_BLOCK (1<<20) /* size of the read buffer */
+#define FAMIO_PAR_MIN (1<<26) /* minimal size of a file parsed in parallel */
+
+/**
+ * Sets read so far, in CSR form, and the state of the current token.
+ */
+typedef struct {
+  ov_idx_t *off; /* off[k] is the start of the set k; off[nsets] is the end */
+  ov_idx_t nsets,off_cap;
+  int *elms;
+  ov_idx_t nelms,elms_cap;
+  int max; /* largest element */
+
+  /* families of a batch file: the sets of the family k are 
+     fam[k]..fam[k+1]-1, and its largest element is fmax[k] */
+  ov_idx_t *fam;
+  int *fmax;
+  int nfam,fam_cap;
+  int cur_max; /* largest element of the current family */
+
+  remap_t *remap; /* NULL, or the renumbering of the elements */
+  remap_id_t lim10; /* largest value of a token, divided by 10 */
+  int limd; /* last digit of the largest value of a token */
+
+  int state; /* 0: between tokens, 1: after '-', 2: in the digits */
+  int neg; /* the current token is negative */
+  remap_id_t val; /* value of the current token */
+  int err;
+} txt_parser_t;
+
+static void parser_init(txt_parser_t *p)
+{
+  p->off_cap=1024;
+  p->off=(ov_idx_t*)malloc(sizeof(ov_idx_t)*(size_t)p->off_cap);
+  p->off[0]=0;
+  p->nsets=0;
+  p->elms_cap=4096;
+  p->elms=(int*)malloc(sizeof(int)*(size_t)p->elms_cap);
+  p->nelms=0;
+  p->max=-1;
+  p->fam=NULL;
+  p->fmax=NULL;
+  p->nfam=p->fam_cap=0;
+  p->cur_max=-1;
+  p->remap=NULL;
+  /* the ground set {0..max} must have at most INT_MAX elements */
+  p->lim10=(INT_MAX-1)/10;
+  p->limd=(INT_MAX-1)%10;
+  p->state=p->neg=p->val=p->err=0;
+}
+
+/**
+ * Grow the table '*t' of '*cap' items of 'size' bytes.
+ * Returns -1 if it would have more than OV_IDX_MAX items, or if memory is
+ * exhausted ('*t' is unchanged).
+ */
+static int parser_grow(void **t,ov_idx_t *cap,size_t size)
+{
+  ov_idx_t c=*cap>OV_IDX_MAX/2?OV_IDX_MAX:2**cap;
+  void *n;
+  if(c==*cap) return -1;
+  if((n=realloc(*t,size*(size_t)c))==NULL) return -1;
+  *t=n;
+  *cap=c;
+  return 0;
+}
+
+static void parser_free(txt_parser_t *p)
+{
+  free(p->off);
+  free(p->elms);
+  free(p->fam);
+  free(p->fmax);
+}
+
+/**
+ * End the current family, if it is not empty
+ */
+static void parser_family(txt_parser_t *p)
+{
+  ov_idx_t first=p->nfam?p->fam[p->nfam]:0;
+  if(p->nsets==first) return;
+  if(p->nfam+2>p->fam_cap) {
+    p->fam_cap=p->fam_cap?2*p->fam_cap:64;
+    p->fam=(ov_idx_t*)realloc(p->fam,sizeof(ov_idx_t)*(size_t)p->fam_cap);
+    p->fmax=(int*)realloc(p->fmax,sizeof(int)*(size_t)p->fam_cap);
+  }
+  p->fam[0]=0;
+  p->fmax[p->nfam]=p->cur_max;
+  p->fam[++p->nfam]=p->nsets;
+  p->cur_max=-1;
+}
+
+/**
+ * End the current token
+ */
+static void parser_token(txt_parser_t *p)
+{
+  if(p->state==1) /* '-' alone */
+    p->err=1;
+  else if(p->neg) { /* end of the set, if it is not empty */
+    if(p->nelms>p->off[p->nsets]) {
+      if(p->nsets+1==p->off_cap 
+	 && parser_grow((void**)&p->off,&p->off_cap,sizeof(ov_idx_t))<0) {
+	p->err=1; /* too many sets */
+	return;
+      }
+      p->off[++p->nsets]=p->nelms;
+    }
+    if(p->val>=2) 
+      parser_family(p);
+  } else {
+    int v=p->remap?remap_get(p->remap,p->val):(int)p->val;
+    if(v<0) 
+      p->err=1;
+    if(p->nelms==p->elms_cap 
+       && parser_grow((void**)&p->elms,&p->elms_cap,sizeof(int))<0) {
+      p->err=1; /* too many elements */
+      return;
+    }
+    p->elms[p->nelms++]=v;
+    if(v>p->max) p->max=v;
+    if(v>p->cur_max) p->cur_max=v;
+  }
+  p->state=p->neg=p->val=0;
+}
+
+/**
+ * Parse 'len' characters. A token may go on in the next call.
+ * Time: O(len)
+ */
+static void parser_parse(txt_parser_t *p,const char *b,size_t len)
+{
+  size_t i;
+  for(i=0;i<len && !p->err;i++) {
+    char c=b[i];
+    if(c>='0' && c<='9') {
+      if(p->val>p->lim10 || (p->val==p->lim10 && c-'0'>p->limd)) 
+	p->err=1; /* too large */
+      p->val=p->val*10+(c-'0');
+      p->state=2;
+    } else if(c==' ' || c=='\n' || c=='\t' || c=='\r' || c=='\v' || c=='\f') {
+      if(p->state) parser_token(p);
+    } else if(c=='-' && p->state==0) {
+      p->neg=1;
+      p->state=1;
+    } else 
+      p->err=1;
+  }
+}
+
+/**
+ * End of the input: the last set may not be ended by -1, nor the last
+ * family by -2.
+ */
+static void parser_end(txt_parser_t *p)
+{
+  if(p->state) parser_token(p);
+  if(!p->err) {
+    p->neg=1;
+    parser_token(p);
+    parser_family(p);
+  }
+}
+
+/**
+ * Parse the file 'fd' by blocks of FAMIO_BLOCK bytes
+ * Time: O(size of the file)
+ */
+static void parser_read(txt_parser_t *p,int fd)
+{
+  char *b=(char*)malloc(FAMIO_BLOCK);
+  ssize_t r;
+  while((r=read(fd,b,FAMIO_BLOCK))!=0) {
+    if(r<0) {
+      if(errno==EINTR) continue;
+      p->err=1;
+      break;
+    }
+    parser_parse(p,b,r);
+  }
+  parser_end(p);
+  free(b);
+}
+
+/**
+ * Open 'file' for reading ("-" is the standard input)
+ */
+static int famio_open(const char *file)
+{
+  if(strcmp(file,"-")==0) 
+    return 0;
+  return open(file,O_RDONLY);
+}
+
+/**
+ * Work of a thread, in the parallel parsing
+ */
+typedef struct {
+  txt_parser_t p;
+  const char *b;
+  size_t len;
+} txt_chunk_t;
+
+static void *parse_chunk(void *data)
+{
+  txt_chunk_t *c=(txt_chunk_t*)data;
+  parser_init(&c->p);
+  parser_parse(&c->p,c->b,c->len);
+  parser_end(&c->p);
+  return NULL;
+}
+
+/**
+ * Returns the first position after a negative token, from 'pos'.
+ * A negative token starts by a '-' after a white space.
+ */
+static size_t next_boundary(const char *b,size_t len,size_t pos)
+{
+  for(;pos<len;pos++)
+    if(b[pos]=='-' && pos>0 && (b[pos-1]==' ' || b[pos-1]=='\n' || b[pos-1]=='\t' || b[pos-1]=='\r')) {
+      while(pos<len && b[pos]!=' ' && b[pos]!='\n' && b[pos]!='\t' && b[pos]!='\r')
+	pos++;
+      return pos;
+    }
+  return len;
+}
+
+/**
+ * Parse the mapped file 'b' with 'nthreads' threads. The file is split in
+ * chunks at the end of sets, each chunk is parsed by a thread, then the 
+ * chunks are concatenated into 'p'.
+ */
+static void parse_parallel(txt_parser_t *p,const char *b,size_t len,int nthreads)
+{
+  txt_chunk_t *c=(txt_chunk_t*)malloc(sizeof(txt_chunk_t)*nthreads);
+  pthread_t *th=(pthread_t*)malloc(sizeof(pthread_t)*nthreads);
+  int *run=(int*)malloc(sizeof(int)*nthreads);
+  size_t pos=0;
+  ov_idx_t nsets=0,nelms=0;
+  ov_idx_t i;
+  int k;
+
+  for(k=0;k<nthreads;k++) {
+    size_t end=(k==nthreads-1)?len:next_boundary(b,len,(len/nthreads)*(k+1));
+    if(end<pos) end=pos;
+    c[k].b=b+pos;
+    c[k].len=end-pos;
+    pos=end;
+  }
+  /* the chunks of the threads which cannot be created are parsed here */
+  for(k=1;k<nthreads;k++)
+    run[k]=pthread_create(&th[k],NULL,parse_chunk,&c[k])==0;
+  parse_chunk(&c[0]);
+  for(k=1;k<nthreads;k++) {
+    if(run[k])
+      pthread_join(th[k],NULL);
+    else
+      parse_chunk(&c[k]);
+  }
+
+  p->err=0;
+  p->max=-1;
+  p->fam=NULL;
+  p->fmax=NULL;
+  p->nfam=p->fam_cap=0;
+  for(k=0;k<nthreads;k++) {
+    p->err|=c[k].p.err;
+    if(c[k].p.nsets>=OV_IDX_MAX-nsets || c[k].p.nelms>OV_IDX_MAX-nelms)
+      p->err=1; /* the sum overflows */
+    else {
+      nsets+=c[k].p.nsets;
+      nelms+=c[k].p.nelms;
+    }
+    if(c[k].p.max>p->max) p->max=c[k].p.max;
+  }
+
+  if(!p->err) {
+    p->off_cap=nsets+1;
+    p->off=(ov_idx_t*)malloc(sizeof(ov_idx_t)*(size_t)p->off_cap);
+    p->elms_cap=nelms>0?nelms:1;
+    p->elms=(int*)malloc(sizeof(int)*(size_t)p->elms_cap);
+    p->off[0]=0;
+    p->nsets=p->nelms=0;
+    for(k=0;k<nthreads;k++) {
+      memcpy(p->elms+p->nelms,c[k].p.elms,sizeof(int)*(size_t)c[k].p.nelms);
+      for(i=1;i<=c[k].p.nsets;i++)
+	p->off[p->nsets+i]=p->nelms+c[k].p.off[i];
+      p->nsets+=c[k].p.nsets;
+      p->nelms+=c[k].p.nelms;
+    }
+  } else {
+    p->off=NULL;
+    p->elms=NULL;
+  }
+
+  for(k=0;k<nthreads;k++)
+    parser_free(&c[k].p);
+  free(c);
+  free(run);
+  free(th);
+}
+
+/**
+ * Read a family in a text file ("-" is the standard input), in one pass.
+ * Large regular files are parsed with 'nthreads' threads.
+ * Returns 0, or -1 if the file cannot be read or is not a family.
+ * Time: O(size of the file + max)
+ */
+int family_read_txt(family_t *f,const char *file,int nthreads)
+{
+  txt_parser_t p;
+  struct stat st;
+  int fd;
+
+  if((fd=famio_open(file))<0) 
+    return -1;
+
+  if(nthreads>1 && fstat(fd,&st)==0 && S_ISREG(st.st_mode) 
+     && st.st_size>=FAMIO_PAR_MIN) {
+    void *b=mmap(NULL,st.st_size,PROT_READ,MAP_PRIVATE,fd,0);
+    if(b==MAP_FAILED) {
+      if(fd) close(fd);
+      return -1;
+    }
+    posix_madvise(b,st.st_size,POSIX_MADV_SEQUENTIAL);
+    parse_parallel(&p,(const char*)b,st.st_size,nthreads);
+    munmap(b,st.st_size);
+  } else {
+    parser_init(&p);
+    parser_read(&p,fd);
+  }
+  if(fd) close(fd);
+
+  if(p.err) {
+    parser_free(&p);
+    errno=EINVAL;
+    return -1;
+  }
+
+  if(family_adopt(f,p.max+1,p.nsets,p.off,p.elms)<0) {
+    parser_free(&p);
+    errno=ENOMEM;
+    return -1;
+  }
+  p.elms=NULL;
+  parser_free(&p);
+  return 0;
+}
+
+/**
+ * Read a family in a text file ("-" is the standard input), in one pass,
+ * where the elements are any integers < 2^64. They are renumbered 
+ * 0..k-1 in order of first occurence, and 'm' gives back the original
+ * identifiers (remap_id). 'm' is initialized here, and must be freed by
+ * remap_free. The ground set of 'f' has k elements.
+ * Returns 0, or -1 if the file cannot be read or is not a family.
+ * Time: O(size of the file) expected
+ */
+int family_read_txt_sparse(family_t *f,remap_t *m,const char *file)
+{
+  txt_parser_t p;
+  int fd;
+
+  remap_init(m);
+  if((fd=famio_open(file))<0) 
+    return -1;
+  parser_init(&p);
+  p.remap=m;
+  p.lim10=(~(remap_id_t)0)/10;
+  p.limd=(int)((~(remap_id_t)0)%10);
+  parser_read(&p,fd);
+  if(fd) close(fd);
+
+  if(p.err) {
+    parser_free(&p);
+    errno=EINVAL;
+    return -1;
+  }
+
+  if(family_adopt(f,m->k,p.nsets,p.off,p.elms)<0) {
+    parser_free(&p);
+    errno=ENOMEM;
+    return -1;
+  }
+  p.elms=NULL;
+  parser_free(&p);
+  return 0;
+}
+
+/**
+ * Print 'f' in the text format, with the original identifiers of 'm'
+ * (see family_read_txt_sparse)
+ */
+void family_print_sparse(const family_t *f,const remap_t *m)
+{
+  ov_idx_t i;
+  int j;
+  for(i=0;i<f->size;i++) {
+    const int *set=family_set(f,i);
+    for(j=0;j<f->sets.size[i];j++)
+      printf("%llu ",remap_id(m,set[j]));
+    printf("-1\n");
+  }
+}
+
+/**
+ * Read a batch file: many families in the text format, every family is 
+ * ended by a token <= -2 ("-" is the standard input). 
+ * The ground set of a family is {0..max}, where max is its largest element.
+ * Returns 0, or -1 if the file cannot be read or is not a batch of 
+ * families.
+ * Time: O(size of the file)
+ */
+int famio_read_batch(famio_batch_t *b,const char *file)
+{
+  txt_parser_t p;
+  int fd,k;
+
+  if((fd=famio_open(file))<0) 
+    return -1;
+  parser_init(&p);
+  parser_read(&p,fd);
+  if(fd) close(fd);
+
+  if(p.err) {
+    parser_free(&p);
+    errno=EINVAL;
+    return -1;
+  }
+
+  b->nfam=p.nfam;
+  b->fam=p.fam?p.fam:(ov_idx_t*)calloc(1,sizeof(ov_idx_t));
+  b->grnd=p.fmax;
+  for(k=0;k<p.nfam;k++)
+    b->grnd[k]++;
+  b->off=p.off;
+  b->elms=p.elms;
+  return 0;
+}
+
+void famio_batch_free(famio_batch_t *b)
+{
+  free(b->fam);
+  free(b->grnd);
+  free(b->off);
+  free(b->elms);
+}
+
+/**
+ * Build a view (see family_view) of the family 'k' of 'b'
+ * Returns 0, or -1 if memory is exhausted.
+ * Time: O(number of sets of the family)
+ */
+int famio_batch_family(const famio_batch_t *b,int k,family_t *f)
+{
+  return family_view(f,b->grnd[k],b->fam[k+1]-b->fam[k],b->off+b->fam[k],b->elms);
+}
+
+/**
+ * Write 'f' in the binary format, sets in the current order of 'f'.
+ * Returns 0, or -1 on error.
+ * Time: O(f->size + \sum_i |X_i|)
+ */
+int family_write_bin(const family_t *f,const char *file)
+{
+  famio_header_t h;
+  FILE *out;
+  ov_idx_t i,o=0;
+  int ok=1;
+
+  if((out=fopen(file,"wb"))==NULL)
+    return -1;
+
+  memset(&h,0,sizeof(h));
+  strcpy(h.magic,FAMIO_MAGIC);
+  h.version=FAMIO_VERSION;
+  h.isize=sizeof(ov_idx_t);
+  h.grnd_size=f->grnd_size;
+  h.nsets=f->size;
+  h.nelms=f->elms_size;
+  h.order=FAMIO_ORDER;
+  ok=ok && fwrite(&h,sizeof(h),1,out)==1;
+
+  for(i=0;i<=f->size && ok;i++) {
+    ok=fwrite(&o,sizeof(ov_idx_t),1,out)==1;
+    if(i<f->size) o+=f->sets.size[i];
+  }
+  for(i=0;i<f->size && ok;i++)
+    ok=fwrite(family_set(f,i),sizeof(int),f->sets.size[i],out)==(size_t)f->sets.size[i];
+
+  if(fclose(out)!=0) ok=0;
+  return ok?0:-1;
+}
+
+/**
+ * Map a binary family file, and build a view of it in 'f' (no copy, 
+ * no parsing). The file stays mapped until famio_unmap, which must be
+ * called after family_free(f).
+ * Returns 0, or -1 if the file cannot be mapped, is not a valid family, or
+ * if memory is exhausted.
+ * Time: O(grnd_size + nsets + nelms) (offsets and sets are checked)
+ */
+int family_map_bin(family_t *f,famio_map_t *m,const char *file)
+{
+  const famio_header_t *h;
+  const ov_idx_t *offsets;
+  const int *elms;
+  struct stat st;
+  overlap_ctx_t *c;
+  long long i,need;
+  int fd,bad;
+
+  m->addr=NULL;
+  m->len=0;
+  if((fd=open(file,O_RDONLY))<0) 
+    return -1;
+  if(fstat(fd,&st)<0 || (size_t)st.st_size<sizeof(famio_header_t)) {
+    close(fd);
+    return -1;
+  }
+  m->len=st.st_size;
+  m->addr=mmap(NULL,m->len,PROT_READ,MAP_PRIVATE,fd,0);
+  close(fd);
+  if(m->addr==MAP_FAILED) {
+    m->addr=NULL;
+    return -1;
+  }
+
+  h=(const famio_header_t*)m->addr;
+  if(memcmp(h->magic,FAMIO_MAGIC,sizeof(FAMIO_MAGIC))!=0 
+     || h->version!=FAMIO_VERSION || h->order!=FAMIO_ORDER 
+     || h->isize!=sizeof(ov_idx_t) || h->nsets<0 || h->nelms<0 
+     || h->grnd_size<0 || h->grnd_size>INT_MAX || h->nsets>=OV_IDX_MAX 
+     || h->nelms>OV_IDX_MAX 
+     || (unsigned long long)h->nsets+1>(unsigned long long)m->len/sizeof(ov_idx_t)
+     || (unsigned long long)h->nelms>(unsigned long long)m->len/sizeof(int)) 
+    need=-1;
+  else
+    need=sizeof(famio_header_t)+(h->nsets+1)*(long long)sizeof(ov_idx_t)
+      +h->nelms*(long long)sizeof(int);
+  if(need<0 || need>(long long)m->len) {
+    famio_unmap(m);
+    errno=EINVAL;
+    return -1;
+  }
+
+  offsets=(const ov_idx_t*)(h+1);
+  elms=(const int*)(offsets+h->nsets+1);
+  if(offsets[0]!=0 || offsets[h->nsets]!=h->nelms) {
+    famio_unmap(m);
+    errno=EINVAL;
+    return -1;
+  }
+  for(i=0;i<h->nsets;i++)
+    if(offsets[i+1]<=offsets[i]) {
+      famio_unmap(m);
+      errno=EINVAL;
+      return -1;
+    }
+
+  posix_madvise(m->addr,m->len,POSIX_MADV_SEQUENTIAL);
+  if(family_view(f,(int)h->grnd_size,(ov_idx_t)h->nsets,offsets,elms)<0) {
+    famio_unmap(m);
+    errno=ENOMEM;
+    return -1;
+  }
+
+  /* the elements are checked as by the readers */
+  c=overlap_ctx_create();
+  bad=family_check_sets_ctx(c,f)<0;
+  overlap_ctx_free(c);
+  if(bad) {
+    family_free(f);
+    famio_unmap(m);
+    errno=EINVAL;
+    return -1;
+  }
+  return 0;
+}
+
+void famio_unmap(famio_map_t *m)
+{
+  if(m->addr) munmap(m->addr,m->len);
+  m->addr=NULL;
+  m->len=0;
+}
+
+/**
+ * Open 'file' to write a family on the ground set {0..grnd_size-1} set by 
+ * set ("-" is the standard output, in the text format only).
+ * Returns 0, or -1 on error.
+ */
+int famio_writer_open(famio_writer_t *w,const char *file,int binary,int grnd_size)
+{
+  famio_header_t h;
+
+  w->binary=binary;
+  w->grnd_size=grnd_size;
+  w->nsets=w->nelms=0;
+  w->len=0;
+  w->err=0;
+  w->tmp=NULL;
+  w->buf=NULL;
+  if(strcmp(file,"-")==0) {
+    if(binary) {
+      errno=EINVAL;
+      return -1;
+    }
+    w->out=stdout;
+  } else if((w->out=fopen(file,binary?"wb":"w"))==NULL)
+    return -1;
+
+  if(binary) {
+    ov_idx_t o=0;
+    /* the header is written again by famio_writer_close */
+    memset(&h,0,sizeof(h));
+    if((w->tmp=tmpfile())==NULL 
+       || fwrite(&h,sizeof(h),1,w->out)!=1 
+       || fwrite(&o,sizeof(ov_idx_t),1,w->out)!=1)
+      w->err=1;
+  } else
+    w->buf=(char*)malloc(FAMIO_BLOCK);
+  if(w->err) {
+    if(w->tmp) fclose(w->tmp);
+    if(w->out!=stdout) fclose(w->out);
+    return -1;
+  }
+  return 0;
+}
+
+/**
+ * Append a set of 'size' elements to the family written by 'w'
+ * Returns 0, or -1 on error.
+ * Time: O(size)
+ */
+int famio_writer_set(famio_writer_t *w,const int *set,int size)
+{
+  int i;
+  if(w->err) return -1;
+  w->nsets++;
+  w->nelms+=size;
+  if(w->binary) {
+    ov_idx_t o;
+    if(w->nsets>=OV_IDX_MAX || w->nelms>OV_IDX_MAX) {
+      errno=EOVERFLOW;
+      w->err=1;
+      return -1;
+    }
+    o=(ov_idx_t)w->nelms;
+    if(fwrite(set,sizeof(int),(size_t)size,w->tmp)!=(size_t)size
+       || fwrite(&o,sizeof(ov_idx_t),1,w->out)!=1)
+      w->err=1;
+    return w->err?-1:0;
+  }
+
+  /* text format: the integers are written by hand, in the buffer */
+  for(i=0;i<=size;i++) {
+    char d[16];
+    int k=0;
+    unsigned int v;
+    if(w->len+sizeof(d)>FAMIO_BLOCK) {
+      if(fwrite(w->buf,1,w->len,w->out)!=w->len) {
+	w->err=1;
+	return -1;
+      }
+      w->len=0;
+    }
+    if(i==size) {
+      memcpy(w->buf+w->len,"-1\n",3);
+      w->len+=3;
+      break;
+    }
+    v=(unsigned int)set[i];
+    do {
+      d[k++]=(char)('0'+v%10);
+      v/=10;
+    } while(v);
+    while(k) w->buf[w->len++]=d[--k];
+    w->buf[w->len++]=' ';
+  }
+  return 0;
+}
+
+/**
+ * End the family written by 'w', and close the file
+ * Returns 0, or -1 if an error occured since famio_writer_open.
+ */
+int famio_writer_close(famio_writer_t *w)
+{
+  int ok=!w->err;
+
+  if(w->binary) {
+    famio_header_t h;
+    char *b=(char*)malloc(FAMIO_BLOCK);
+    size_t n;
+    memset(&h,0,sizeof(h));
+    strcpy(h.magic,FAMIO_MAGIC);
+    h.version=FAMIO_VERSION;
+    h.isize=sizeof(ov_idx_t);
+    h.grnd_size=w->grnd_size;
+    h.nsets=w->nsets;
+    h.nelms=w->nelms;
+    h.order=FAMIO_ORDER;
+    ok=ok && fflush(w->tmp)==0 && fseek(w->tmp,0,SEEK_SET)==0;
+    while(ok && (n=fread(b,1,FAMIO_BLOCK,w->tmp))>0)
+      ok=fwrite(b,1,n,w->out)==n;
+    ok=ok && !ferror(w->tmp) && fseek(w->out,0,SEEK_SET)==0 
+      && fwrite(&h,sizeof(h),1,w->out)==1;
+    free(b);
+    fclose(w->tmp);
+  } else {
+    ok=ok && fwrite(w->buf,1,w->len,w->out)==w->len;
+    free(w->buf);
+  }
+  if(w->out==stdout)
+    ok=fflush(stdout)==0 && ok;
+  else if(fclose(w->out)!=0) 
+    ok=0;
+  return ok?0:-1;
+}
@@ -0,0 +1,104 @@
+/*
+ *   This source file is part of program computing set overlap classes 
+ *   in linear time.
+ *   Copyright (C) 2007  Michael Rao
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _FAMIO_H_
+#define _FAMIO_H_
+
+#include <stddef.h>
+#include <stdio.h>
+#include "overlap.h"
+#include "remap.h"
+
+/*
+ * Binary family format (version 1), in native byte order:
+ * - a header (famio_header_t, 48 bytes)
+ * - offsets: nsets+1 integers of 'isize' bytes (ov_idx_t), offsets[0]=0, 
+ *   offsets[nsets]=nelms
+ * - elements: nelms integers of sizeof(int) bytes. The elements of the 
+ *   set j are elements[offsets[j] .. offsets[j+1]-1]
+ * A file is only read by a build with the same index type.
+ * The tables can be mmap'd and used by family_view without any parsing.
+ */
+
+#define FAMIO_MAGIC "OVLPFAM"
+#define FAMIO_VERSION 1
+#define FAMIO_ORDER 0x01020304
+
+typedef struct {
+  char magic[8]; /* FAMIO_MAGIC */
+  unsigned int version; /* FAMIO_VERSION */
+  unsigned int isize; /* sizeof(ov_idx_t) of the writer */
+  long long grnd_size;
+  long long nsets;
+  long long nelms; /* \sum_i |X_i| */
+  unsigned int order; /* FAMIO_ORDER, to detect the byte order */
+  unsigned int reserved;
+} famio_header_t;
+
+/**
+ * A mapped binary family file
+ */
+typedef struct {
+  void *addr;
+  size_t len;
+} famio_map_t;
+
+/**
+ * A batch of families read in a text file, in CSR form: the sets of the 
+ * family k are fam[k]..fam[k+1]-1, the elements of the set j are 
+ * elms[off[j] .. off[j+1]-1].
+ */
+typedef struct {
+  int nfam;
+  ov_idx_t *fam; /* nfam+1 entries */
+  int *grnd; /* size of the ground set of each family */
+  ov_idx_t *off;
+  int *elms;
+} famio_batch_t;
+
+/**
+ * A family written set by set, in the text or the binary format, without
+ * keeping it in memory. In the binary format the elements go first to a
+ * temporary file, which is copied after the offsets by famio_writer_close.
+ */
+typedef struct {
+  FILE *out;
+  FILE *tmp; /* elements (binary format) */
+  int binary;
+  int grnd_size;
+  long long nsets,nelms;
+  char *buf; /* output buffer (text format) */
+  size_t len;
+  int err;
+} famio_writer_t;
+
+extern int family_read_txt(family_t *f,const char *file,int nthreads);
+extern int family_read_txt_sparse(family_t *f,remap_t *m,const char *file);
+extern void family_print_sparse(const family_t *f,const remap_t *m);
+extern int famio_read_batch(famio_batch_t *b,const char *file);
+extern int famio_batch_family(const famio_batch_t *b,int k,family_t *f);
+extern void famio_batch_free(famio_batch_t *b);
+extern int family_write_bin(const family_t *f,const char *file);
+extern int family_map_bin(family_t *f,famio_map_t *m,const char *file);
+extern void famio_unmap(famio_map_t *m);
+extern int famio_writer_open(famio_writer_t *w,const char *file,int binary,int grnd_size);
+extern int famio_writer_set(famio_writer_t *w,const int *set,int size);
+extern int famio_writer_close(famio_writer_t *w);
+
+#endif
@@ -17,10 +17,16 @@
  *   along with this program. If not, see <http://www.gnu.org/licenses/>.
  */
 
+#define _POSIX_C_SOURCE 200809L
+
 #include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
+#include <errno.h>
 #include <time.h>
+#include <pthread.h>
 #include "gen.h"
+#include "famio.h"
 
 /**
  * Generates a family of sets. 
@@ -28,37 +34,38 @@
  * don't overlap any set in the inclusion tree.
  * We do so to avoid the case where the overlap graph has only one 
  * connected component.
+ * The state of the random generator ('seed', for rand_r) is given to every
+ * function, so that family_gen is reentrant.
  */
 
 
 /**
  * Generate a table 't' of 's' random bits.
  */
-static int randtab(int *t,int s)
+static int randtab(int *t,int s,unsigned int *seed)
 {
   int r=0;
   int i;
   for(i=0;i<s;i++)
-    r+=(t[i]=rand()%2);
+    r+=(t[i]=rand_r(seed)%2);
   return r;
 }
 
 /** 
  * Computes the usion of sets in f2.
- * The result is set in 'ta', and the size in 'sa'.
+ * The result is set in 'ta' (which has room for all the elements of 'f2'),
+ * and the size in 'sa'.
  * 't' is a table of bits saying which set in 'f2' has to be in the union.
  */
-static void unionsets(const family_t *f2,int *t, int **ta,int *sa)
+static void unionsets(const family_t *f2,const int *t, int *ta,int *sa)
 {
-  int i,p=0,j;
+  int i,j;
   *sa=0;
-  for(i=0;i<f2->size;i++)
-    if(t[i]) *sa+=f2->sets[i].size;
-  *ta=(int*)malloc(*sa*sizeof(int));
   for(i=0;i<f2->size;i++)
     if(t[i]) {
-      for(j=0;j<f2->sets[i].size;j++)
-	(*ta)[p++]=f2->sets[i].set[j];
+      const int *set=family_set(f2,i);
+      for(j=0;j<f2->sets.size[i];j++)
+	ta[(*sa)++]=set[j];
     }
 }
 
@@ -66,41 +73,41 @@ static void unionsets(const family_t *f2,int *t, int **ta,int *sa)
  * Generate 'nbr' sets, usings sets of 'f2' as atoms.
  * Adds the sets in 'f'.
  */
-static void gen1(family_t *f, const family_t *f2, int nbr)
+static void gen1(family_t *f, const family_t *f2, int nbr,unsigned int *seed)
 {
-  int *t;
+  int *t,*ta;
   /*printf("gen1 %d %d\n",f2->size,nbr);*/
   if(f2->size<3) return;
   t=(int*)malloc(f2->size*sizeof(int));
+  ta=(int*)malloc(f2->elms_size*sizeof(int));
   while(nbr) {
-    int r=randtab(t,f2->size);
+    int r=randtab(t,(int)f2->size,seed);
     if(r>1 && r<f2->size) {
-      int *ta;
       int sa;
-      unionsets(f2,t,&ta,&sa);
+      unionsets(f2,t,ta,&sa);
       family_add_set(f,sa,ta);
-      free(ta);
       nbr--;
     }
   }
+  free(t);
+  free(ta);
 }
 
 
 /**
  * Generate a table 't' of 's' random integers from 1 to 'a'
  */
-static void randtab2(int *t,int s,int a)
+static void randtab2(int *t,int s,int a,unsigned int *seed)
 {
-  int s2=0;
-  int i,o=-1;
-  for(i=0;i<s;i++) {
-    s2++;
-    t[i]=1+(rand()%a);
-    if(o==-1) o=t[i];
-    if(o>0 && o!=t[i]) o=-2;
-  }
-  if(s2>1 && o!=-2) /* verify that this is a proper partition */
-    randtab2(t,s,a); /* otherwise, retry */
+  int i,o;
+  do { /* retry until this is a proper partition */
+    o=-1;
+    for(i=0;i<s;i++) {
+      t[i]=1+(rand_r(seed)%a);
+      if(o==-1) o=t[i];
+      if(o>0 && o!=t[i]) o=-2;
+    }
+  } while(s>1 && o!=-2);
 }
 
 /**
@@ -109,18 +116,19 @@ static void randtab2(int *t,int s,int a)
  * Runs gen1 on the partition.
  * Recursively runs gen on the classes of the partition
  */
-static void gen(family_t *f, int grnd, int *ta, int sa,int degree, float dens)
+static void gen(family_t *f, int grnd, int *ta, int sa,int degree, float dens,unsigned int *seed)
 {
   family_t f2;
-  int *tb=(int*)malloc(sa*sizeof(int));
-  int *tc=(int*)malloc(sa*sizeof(int));
+  int *tb,*tc;
   int i,r=0,j;
   int d=0;
 
   if(sa<=1) return;
   
+  tb=(int*)malloc(sa*sizeof(int));
+  tc=(int*)malloc(sa*sizeof(int));
   family_create(&f2,grnd);
-  randtab2(tb,sa,degree);
+  randtab2(tb,sa,degree,seed);
   for(i=1;i<=degree;i++) {
     r=0;
     for(j=0;j<sa;j++) {
@@ -132,11 +140,11 @@ static void gen(family_t *f, int grnd, int *ta, int sa,int degree, float dens)
       d++;
       family_add_set(&f2,r,tc);
       /*family_add_set(f,r,tc);*/
-      gen(f,grnd,tc,r,degree,dens);
+      gen(f,grnd,tc,r,degree,dens,seed);
     }
   }
   
-  gen1(f,&f2,(d*d)*dens);
+  gen1(f,&f2,(d*d)*dens,seed);
   
   family_free(&f2);
   free(tb);
@@ -145,20 +153,500 @@ static void gen(family_t *f, int grnd, int *ta, int sa,int degree, float dens)
 
 /**
  * Generate a family.
+ * If 'seed' is 0, the seed is taken from the time (and differs between 
+ * two calls in the same second).
  */ 
 void family_gen(family_t *f,int grnd, int degree, float dens,int seed)
 {
   static int r=0;
   int *ta=(int*)malloc(grnd*sizeof(int));
+  unsigned int s;
   int i;
 
   if(seed==0)
-    srand(time(NULL)+r++);
+    s=time(NULL)+__sync_fetch_and_add(&r,1);
   else
-    srand(seed);
+    s=seed;
   
   for(i=0;i<grnd;i++)
     ta[i]=i;
-  gen(f,grnd,ta,grnd,degree,dens);
+  gen(f,grnd,ta,grnd,degree,dens,&s);
   free(ta);
 }
+
+/*
+ * Parallel generator (family_gen_parallel and family_gen_write).
+ * It builds the same kind of inclusion tree as family_gen, but the random
+ * numbers come from a counter-based generator: the k-th number of a node
+ * is a hash of the key of the node and of k, and the key of a child is a
+ * hash of the key of its parent and of its rank. Thus every subtree can be
+ * generated alone, and the family only depends on the seed (not on the
+ * number of threads).
+ * A node is a range of the table of the elements. It is partitioned in 
+ * place (its classes become consecutive ranges), then its subtrees are 
+ * generated, then its sets (unions of classes), as in family_gen.
+ * The subtrees of at most GEN_TASK elements are tasks, generated by the
+ * threads in buffers. The nodes above them are partitioned first, then the
+ * main thread gives the sets in order: the buffers of the tasks, and the 
+ * sets of the nodes above them. The threads are at most GEN_WINDOW*nthreads
+ * nodes ahead of it.
+ */
+
+#define GEN_TASK (1<<15) /* largest subtree of a task */
+#define GEN_WINDOW 4
+
+typedef unsigned long long gen_key_t;
+
+/**
+ * Hash of 64 bits (finalizer of splitmix64)
+ */
+static gen_key_t gen_hash(gen_key_t z)
+{
+  z+=0x9e3779b97f4a7c15ULL;
+  z=(z^(z>>30))*0xbf58476d1ce4e5b9ULL;
+  z=(z^(z>>27))*0x94d049bb133111ebULL;
+  return z^(z>>31);
+}
+
+/* k-th random number of the node 'key', in [0,a[ */
+static int gen_rand(gen_key_t key,gen_key_t k,int a)
+{
+  return (int)((gen_hash(key^gen_hash(k))>>33)%(gen_key_t)a);
+}
+
+/* key of the c-th child of the node 'key' */
+static gen_key_t gen_child(gen_key_t key,int c)
+{
+  return gen_hash(key+0xd1b54a32d192ed03ULL*(gen_key_t)(c+1));
+}
+
+/**
+ * Function receiving the generated sets. Returns 0, or -1 on error.
+ */
+typedef int (*gen_emit_t)(void *data,const int *set,int size);
+
+/**
+ * Scratch tables of a thread
+ */
+typedef struct {
+  int degree;
+  float dens;
+  int *tmp,*set; /* 'cap' entries */
+  int cap;
+  int *cnt,*bits; /* 'degree' entries */
+  int *cls; /* classes of the nodes of the current path */
+  size_t cls_cap;
+} gen_work_t;
+
+static void gen_work_init(gen_work_t *w,int degree,float dens,int cap)
+{
+  w->degree=degree;
+  w->dens=dens;
+  w->cap=cap>0?cap:1;
+  w->tmp=(int*)malloc(sizeof(int)*(size_t)w->cap);
+  w->set=(int*)malloc(sizeof(int)*(size_t)w->cap);
+  w->cnt=(int*)malloc(sizeof(int)*(size_t)degree);
+  w->bits=(int*)malloc(sizeof(int)*(size_t)degree);
+  w->cls_cap=16*((size_t)degree+1);
+  w->cls=(int*)malloc(sizeof(int)*w->cls_cap);
+}
+
+static void gen_work_free(gen_work_t *w)
+{
+  free(w->tmp);
+  free(w->set);
+  free(w->cnt);
+  free(w->bits);
+  free(w->cls);
+}
+
+/**
+ * Partition the node 'ta' of 'sa'>=2 elements into d>=2 classes (random
+ * numbers are drawn again until the partition is proper), and reorder 
+ * 'ta' by class. The class c is ta[cls[base+c] .. cls[base+c+1]-1].
+ * Returns d.
+ * Time: O(sa+degree) expected
+ */
+static int gen_partition(gen_work_t *w,int *ta,int sa,gen_key_t key,size_t base)
+{
+  int *cnt=w->cnt;
+  int i,d,p,deg=w->degree;
+  gen_key_t k;
+
+  for(k=0;;k+=(gen_key_t)sa) {
+    for(i=0;i<deg;i++)
+      cnt[i]=0;
+    for(i=0;i<sa;i++)
+      cnt[gen_rand(key,k+i,deg)]++;
+    for(d=0,i=0;i<deg;i++)
+      if(cnt[i]) d++;
+    if(d>=2) break;
+  }
+
+  if(base+(size_t)deg+1>w->cls_cap) {
+    w->cls_cap=2*(base+(size_t)deg+1);
+    w->cls=(int*)realloc(w->cls,sizeof(int)*w->cls_cap);
+  }
+  w->cls[base]=0;
+  for(d=0,p=0,i=0;i<deg;i++) {
+    int c=cnt[i];
+    if(c) {
+      w->cls[base+d+1]=w->cls[base+d]+c;
+      d++;
+    }
+    cnt[i]=p;
+    p+=c;
+  }
+  for(i=0;i<sa;i++)
+    w->tmp[cnt[gen_rand(key,k+i,deg)]++]=ta[i];
+  memcpy(ta,w->tmp,sizeof(int)*(size_t)sa);
+  return d;
+}
+
+/**
+ * Generate the sets of the node 'ta' (as gen1): unions of at least 2 and
+ * at most d-1 of its d classes, given by 'cls' (see gen_partition).
+ * Returns 0, or -1 if 'emit' fails.
+ */
+static int gen_sets(gen_work_t *w,const int *ta,const int *cls,int d,gen_key_t key,gen_emit_t emit,void *data)
+{
+  int nbr=(int)((d*d)*w->dens);
+  gen_key_t k=0;
+  int i;
+
+  if(d<3) return 0;
+  key=gen_hash(~key);
+  while(nbr) {
+    int r=0;
+    for(i=0;i<d;i++)
+      r+=(w->bits[i]=gen_rand(key,k++,2));
+    if(r>1 && r<d) {
+      int sa=0;
+      for(i=0;i<d;i++)
+	if(w->bits[i]) {
+	  int s=cls[i],e=cls[i+1];
+	  memcpy(w->set+sa,ta+s,sizeof(int)*(size_t)(e-s));
+	  sa+=e-s;
+	}
+      if(emit(data,w->set,sa)<0) 
+	return -1;
+      nbr--;
+    }
+  }
+  return 0;
+}
+
+/**
+ * Generate the subtree of the node 'ta' of 'sa' elements
+ * ('w' has room for 'sa' elements). The classes of the node are put 
+ * at 'base' in w->cls.
+ * Returns 0, or -1 if 'emit' fails.
+ */
+static int gen_tree(gen_work_t *w,int *ta,int sa,gen_key_t key,size_t base,gen_emit_t emit,void *data)
+{
+  int c,d;
+  if(sa<=1) return 0;
+  d=gen_partition(w,ta,sa,key,base);
+  for(c=0;c<d;c++) {
+    int s=w->cls[base+c],e=w->cls[base+c+1];
+    if(gen_tree(w,ta+s,e-s,gen_child(key,c),base+d+1,emit,data)<0)
+      return -1;
+  }
+  return gen_sets(w,ta,w->cls+base,d,key,emit,data);
+}
+
+/**
+ * A node of the plan: a task (a subtree generated by a thread into a
+ * buffer, in CSR form), or a node above the tasks, whose classes are in
+ * the plan.
+ */
+typedef struct {
+  int task;
+  int start,size; /* range of the node in the table of the elements */
+  gen_key_t key;
+  size_t cls; /* node above the tasks: its classes in the plan */
+  int d;
+  int done;
+  size_t *off; /* task: off[n] sets */
+  int *elms;
+  size_t n,off_cap,elms_cap;
+} gen_item_t;
+
+typedef struct {
+  int *ta; /* the ground set, reordered by the partitions */
+  int degree;
+  float dens;
+  gen_item_t *it; /* in the order of the sets */
+  size_t nit,it_cap;
+  int *cls; /* classes of the nodes above the tasks */
+  size_t ncls,cls_cap;
+
+  gen_work_t w; /* scratch of the main thread */
+  gen_emit_t emit;
+  void *data;
+
+  size_t next; /* first node not taken by a thread */
+  size_t written; /* nodes given to 'emit' */
+  size_t window;
+  int err;
+  pthread_mutex_t mut;
+  pthread_cond_t cond;
+} gen_run_t;
+
+static gen_item_t *gen_new_item(gen_run_t *r)
+{
+  gen_item_t *it;
+  if(r->nit==r->it_cap) {
+    r->it_cap=2*r->it_cap+16;
+    r->it=(gen_item_t*)realloc(r->it,sizeof(gen_item_t)*r->it_cap);
+  }
+  it=r->it+r->nit++;
+  memset(it,0,sizeof(gen_item_t));
+  return it;
+}
+
+/**
+ * Cut the tree into tasks, in the order of the sets. The nodes of more 
+ * than GEN_TASK elements are partitioned now.
+ * Time: O(sa*depth) for the nodes above the tasks
+ */
+static void gen_plan(gen_run_t *r,int start,int sa,gen_key_t key)
+{
+  gen_item_t *it;
+  int c,d;
+  size_t p;
+
+  if(sa<=1) return;
+  if(sa<=GEN_TASK) {
+    it=gen_new_item(r);
+    it->task=1;
+    it->start=start;
+    it->size=sa;
+    it->key=key;
+    return;
+  }
+
+  d=gen_partition(&r->w,r->ta+start,sa,key,0);
+  if(r->ncls+(size_t)d+1>r->cls_cap) {
+    r->cls_cap=2*(r->ncls+(size_t)d+1);
+    r->cls=(int*)realloc(r->cls,sizeof(int)*r->cls_cap);
+  }
+  p=r->ncls;
+  memcpy(r->cls+p,r->w.cls,sizeof(int)*((size_t)d+1));
+  r->ncls+=(size_t)d+1;
+  for(c=0;c<d;c++)
+    gen_plan(r,start+r->cls[p+c],r->cls[p+c+1]-r->cls[p+c],gen_child(key,c));
+
+  it=gen_new_item(r);
+  it->start=start;
+  it->size=sa;
+  it->key=key;
+  it->cls=p;
+  it->d=d;
+}
+
+/* append a set to the buffer of a task */
+static int gen_to_item(void *data,const int *set,int size)
+{
+  gen_item_t *it=(gen_item_t*)data;
+  size_t ne=it->n?it->off[it->n]:0;
+  if(it->n+2>it->off_cap) {
+    it->off_cap=2*it->off_cap+64;
+    it->off=(size_t*)realloc(it->off,sizeof(size_t)*it->off_cap);
+  }
+  if(ne+(size_t)size>it->elms_cap) {
+    it->elms_cap=2*it->elms_cap+(size_t)size;
+    it->elms=(int*)realloc(it->elms,sizeof(int)*it->elms_cap);
+  }
+  it->off[0]=0;
+  memcpy(it->elms+ne,set,sizeof(int)*(size_t)size);
+  it->off[++it->n]=ne+(size_t)size;
+  return 0;
+}
+
+/**
+ * A thread: takes the next task in the window, and generates it in its
+ * buffer
+ */
+static void *gen_worker(void *arg)
+{
+  gen_run_t *r=(gen_run_t*)arg;
+  gen_work_t w;
+
+  gen_work_init(&w,r->degree,r->dens,GEN_TASK);
+  pthread_mutex_lock(&r->mut);
+  while(1) {
+    gen_item_t *it;
+    while(r->next<r->nit && !r->it[r->next].task)
+      r->next++;
+    if(r->next>=r->nit) break;
+    if(r->next>=r->written+r->window) {
+      pthread_cond_wait(&r->cond,&r->mut);
+      continue;
+    }
+    it=r->it+r->next++;
+    pthread_mutex_unlock(&r->mut);
+
+    gen_tree(&w,r->ta+it->start,it->size,it->key,0,gen_to_item,it);
+
+    pthread_mutex_lock(&r->mut);
+    it->done=1;
+    pthread_cond_broadcast(&r->cond);
+  }
+  pthread_mutex_unlock(&r->mut);
+  gen_work_free(&w);
+  return NULL;
+}
+
+/**
+ * Give the sets of the nodes to 'emit', in order. The tasks not taken by 
+ * a thread are generated here, without buffer.
+ * Returns 0, or -1 if 'emit' fails.
+ */
+static int gen_write(gen_run_t *r)
+{
+  size_t i,j;
+  int ok=1;
+
+  for(i=0;i<r->nit && ok;i++) {
+    gen_item_t *it=r->it+i;
+    if(!it->task) 
+      ok=gen_sets(&r->w,r->ta+it->start,r->cls+it->cls,it->d,it->key,r->emit,r->data)==0;
+    else {
+      int mine=0;
+      pthread_mutex_lock(&r->mut);
+      if(r->next<=i) {
+	r->next=i+1;
+	mine=1;
+      } else
+	while(!it->done)
+	  pthread_cond_wait(&r->cond,&r->mut);
+      pthread_mutex_unlock(&r->mut);
+
+      if(mine)
+	ok=gen_tree(&r->w,r->ta+it->start,it->size,it->key,0,r->emit,r->data)==0;
+      else
+	for(j=0;j<it->n && ok;j++)
+	  ok=r->emit(r->data,it->elms+it->off[j],(int)(it->off[j+1]-it->off[j]))==0;
+      free(it->off);
+      free(it->elms);
+      it->off=NULL;
+      it->elms=NULL;
+    }
+
+    pthread_mutex_lock(&r->mut);
+    r->written=i+1;
+    if(!ok) r->next=r->nit; /* stop the threads */
+    pthread_cond_broadcast(&r->cond);
+    pthread_mutex_unlock(&r->mut);
+  }
+  return ok?0:-1;
+}
+
+/**
+ * Generate a family with the parallel generator, and give its sets to
+ * 'emit'. Returns 0, or -1 on error.
+ * Time: O(grnd*depth + \sum_i |X_i|) expected, where depth is the depth
+ * of the inclusion tree
+ * Memory: O(grnd) besides the buffers of the window
+ */
+static int gen_run(int grnd,int degree,float dens,int seed,int nthreads,gen_emit_t emit,void *data)
+{
+  static int rs=0;
+  gen_run_t r;
+  pthread_t *th;
+  gen_key_t key;
+  size_t j;
+  int i,k,nt,ret;
+
+  if(grnd<0 || degree<2) {
+    errno=EINVAL;
+    return -1;
+  }
+  if(nthreads<1) nthreads=1;
+  if(seed==0)
+    key=(gen_key_t)time(NULL)+(gen_key_t)__sync_fetch_and_add(&rs,1);
+  else
+    key=(gen_key_t)(unsigned int)seed;
+  key=gen_hash(key);
+
+  memset(&r,0,sizeof(r));
+  r.degree=degree;
+  r.dens=dens;
+  r.emit=emit;
+  r.data=data;
+  r.window=GEN_WINDOW*(size_t)nthreads;
+  pthread_mutex_init(&r.mut,NULL);
+  pthread_cond_init(&r.cond,NULL);
+  r.ta=(int*)malloc(sizeof(int)*(size_t)(grnd>0?grnd:1));
+  for(i=0;i<grnd;i++)
+    r.ta[i]=i;
+  gen_work_init(&r.w,degree,dens,grnd);
+
+  gen_plan(&r,0,grnd,key);
+
+  /* the tasks of the threads which cannot be created are left to gen_write */
+  th=(pthread_t*)malloc(sizeof(pthread_t)*(size_t)nthreads);
+  for(k=1,nt=1;k<nthreads;k++)
+    if(pthread_create(&th[nt],NULL,gen_worker,&r)==0)
+      nt++;
+  ret=gen_write(&r);
+  for(k=1;k<nt;k++)
+    pthread_join(th[k],NULL);
+
+  for(j=0;j<r.nit;j++) {
+    free(r.it[j].off);
+    free(r.it[j].elms);
+  }
+  free(th);
+  free(r.it);
+  free(r.cls);
+  free(r.ta);
+  gen_work_free(&r.w);
+  pthread_mutex_destroy(&r.mut);
+  pthread_cond_destroy(&r.cond);
+  return ret;
+}
+
+static int gen_to_family(void *data,const int *set,int size)
+{
+  return family_add_set((family_t*)data,size,set)<0?-1:0;
+}
+
+/**
+ * Generate a family in 'f' (created on a ground set of 'grnd' elements)
+ * with 'nthreads' threads. The family only depends on the seed (see 
+ * family_gen for 'seed'=0).
+ * Returns 0, or -1 on error.
+ */
+int family_gen_parallel(family_t *f,int grnd,int degree,float dens,int seed,int nthreads)
+{
+  return gen_run(grnd,degree,dens,seed,nthreads,gen_to_family,f);
+}
+
+static int gen_to_writer(void *data,const int *set,int size)
+{
+  return famio_writer_set((famio_writer_t*)data,set,size);
+}
+
+/**
+ * Generate a family as family_gen_parallel, and write it set by set in 
+ * 'file', in the text or the binary format (see famio_writer_t), without 
+ * keeping it in memory. '*nsets' and '*nelms' get the number of sets 
+ * and \sum_i |X_i| (if not NULL).
+ * Returns 0, or -1 on error.
+ */
+int family_gen_write(const char *file,int binary,int grnd,int degree,float dens,int seed,int nthreads,long long *nsets,long long *nelms)
+{
+  famio_writer_t w;
+  int ret;
+
+  if(famio_writer_open(&w,file,binary,grnd)<0) 
+    return -1;
+  ret=gen_run(grnd,degree,dens,seed,nthreads,gen_to_writer,&w);
+  if(famio_writer_close(&w)<0) 
+    ret=-1;
+  if(nsets) *nsets=w.nsets;
+  if(nelms) *nelms=w.nelms;
+  return ret;
+}
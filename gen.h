@@ -23,5 +23,7 @@
 #include "overlap.h"
 
 extern void family_gen(family_t *f,int grnd, int degree, float dens,int seed);
+extern int family_gen_parallel(family_t *f,int grnd,int degree,float dens,int seed,int nthreads);
+extern int family_gen_write(const char *file,int binary,int grnd,int degree,float dens,int seed,int nthreads,long long *nsets,long long *nelms);
 
 #endif
@@ -0,0 +1,255 @@
+/*
+ *   This source file is part of program computing set overlap classes 
+ *   in linear time.
+ *   Copyright (C) 2007  Michael Rao
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdlib.h>
+#include "incr.h"
+
+/*
+ * Incremental overlap components.
+ * A new set X can only overlap a set Y if X meets the union of the 
+ * component of Y, and the relations between old sets do not change. Thus
+ * when sets are added, only the components whose union meets a new set
+ * ("touched" components) can change: their sets are recomputed together
+ * with the new sets by compute_overlap_components_ctx, and the other 
+ * components are kept.
+ * For every element, we keep the list of the components whose union 
+ * contains it, so the touched components are found in time proportional
+ * to the new sets (times the length of these lists).
+ */
+
+/**
+ * Returns a capacity >= need, growing 'cap' geometrically
+ */
+static ov_idx_t incr_newcap(ov_idx_t cap,ov_idx_t need)
+{
+  if(cap<16) cap=16;
+  while(cap<need) cap*=2;
+  return cap;
+}
+
+/**
+ * Create an empty structure on the ground set {0..grnd_size-1}
+ * Time: O(grnd_size)
+ */
+void incr_create(incr_t *a,int grnd_size)
+{
+  int g=grnd_size>0?grnd_size:1;
+  a->ctx=overlap_ctx_create();
+  family_create_ctx(a->ctx,&a->f,grnd_size);
+  family_create_ctx(a->ctx,&a->sub,grnd_size);
+  a->label=a->set_next=NULL;
+  a->set_cap=0;
+  a->ncomp=0;
+  a->ncomp_ids=a->comp_cap=0;
+  a->comp_first=a->comp_size=a->touched=NULL;
+  a->dead=a->comp_stamp=NULL;
+  a->el=(ov_idx_t**)calloc(g,sizeof(ov_idx_t*));
+  a->el_len=(ov_idx_t*)calloc(g,sizeof(ov_idx_t));
+  a->el_cap=(ov_idx_t*)calloc(g,sizeof(ov_idx_t));
+  a->stamp=(int*)calloc(g,sizeof(int));
+  a->now=0;
+  a->gid=a->dq=NULL;
+  overlap_groups_init(&a->grp);
+  a->sub_cap=0;
+}
+
+void incr_free(incr_t *a)
+{
+  int i;
+  for(i=0;i<a->f.grnd_size;i++)
+    free(a->el[i]);
+  free(a->el);
+  free(a->el_len);
+  free(a->el_cap);
+  free(a->stamp);
+  free(a->label);
+  free(a->set_next);
+  free(a->comp_first);
+  free(a->comp_size);
+  free(a->dead);
+  free(a->comp_stamp);
+  free(a->touched);
+  free(a->gid);
+  overlap_groups_free(&a->grp);
+  free(a->dq);
+  family_free(&a->sub);
+  family_free(&a->f);
+  overlap_ctx_free(a->ctx);
+}
+
+/**
+ * Returns a new component identifier
+ * Time: O(1) amortized
+ */
+static ov_idx_t incr_new_comp(incr_t *a)
+{
+  ov_idx_t c=a->ncomp_ids++;
+  if(c==a->comp_cap) {
+    a->comp_cap=incr_newcap(a->comp_cap,c+1);
+    a->comp_first=(ov_idx_t*)realloc(a->comp_first,sizeof(ov_idx_t)*a->comp_cap);
+    a->comp_size=(ov_idx_t*)realloc(a->comp_size,sizeof(ov_idx_t)*a->comp_cap);
+    a->dead=(int*)realloc(a->dead,sizeof(int)*(size_t)a->comp_cap);
+    a->comp_stamp=(int*)realloc(a->comp_stamp,sizeof(int)*(size_t)a->comp_cap);
+    a->touched=(ov_idx_t*)realloc(a->touched,sizeof(ov_idx_t)*a->comp_cap);
+  }
+  a->comp_first[c]=-1;
+  a->comp_size[c]=0;
+  a->dead[c]=0;
+  a->comp_stamp[c]=0;
+  return c;
+}
+
+/**
+ * The element 'e' is in the union of the component 'd': remove the dead
+ * components from its list, and add 'd'.
+ * Time: O(length of the list)
+ */
+static void incr_update_elm(incr_t *a,int e,ov_idx_t d)
+{
+  ov_idx_t i,k=0;
+  ov_idx_t *l=a->el[e];
+  for(i=0;i<a->el_len[e];i++)
+    if(!a->dead[l[i]] && l[i]!=d)
+      l[k++]=l[i];
+  if(k==a->el_cap[e]) {
+    a->el_cap[e]=a->el_cap[e]?2*a->el_cap[e]:2;
+    l=a->el[e]=(ov_idx_t*)realloc(l,sizeof(ov_idx_t)*a->el_cap[e]);
+  }
+  l[k++]=d;
+  a->el_len[e]=k;
+}
+
+/**
+ * Add 'nbr' sets given in CSR form (as family_add_sets_bulk), and update
+ * the components. The new sets are a->f.sets[first..first+nbr-1], where
+ * 'first' is a->f.size before the call.
+ * Returns the number of components, or -1 if the sets cannot be added
+ * (see family_add_sets_bulk).
+ * Time: O(nbr + \sum |new sets| + \sum |sets of the touched components|)
+ */
+ov_idx_t incr_add_sets(incr_t *a,ov_idx_t nbr,const ov_idx_t *offsets,const int *elms)
+{
+  family_t *f=&a->f,*sub=&a->sub;
+  ov_idx_t first=f->size;
+  ov_idx_t i,j,k,q,p,n,nt=0;
+
+  if(family_add_sets_bulk(f,nbr,offsets,elms)<0) return -1;
+  if(f->size>a->set_cap) {
+    a->set_cap=incr_newcap(a->set_cap,f->size);
+    a->label=(ov_idx_t*)realloc(a->label,sizeof(ov_idx_t)*a->set_cap);
+    a->set_next=(ov_idx_t*)realloc(a->set_next,sizeof(ov_idx_t)*a->set_cap);
+  }
+  for(i=first;i<f->size;i++)
+    a->label[i]=-1;
+
+  /* the touched components */
+  a->now++;
+  n=nbr;
+  for(i=first;i<f->size;i++) {
+    const int *set=family_set(f,i);
+    for(j=0;j<f->sets.size[i];j++) {
+      const ov_idx_t *l=a->el[set[j]];
+      for(k=0;k<a->el_len[set[j]];k++)
+	if(a->comp_stamp[l[k]]!=a->now) {
+	  a->comp_stamp[l[k]]=a->now;
+	  a->touched[nt++]=l[k];
+	  n+=a->comp_size[l[k]];
+	}
+    }
+  }
+
+  /* the family to recompute: the touched components, then the new sets */
+  if(n>a->sub_cap) {
+    a->sub_cap=incr_newcap(a->sub_cap,n);
+    a->gid=(ov_idx_t*)realloc(a->gid,sizeof(ov_idx_t)*a->sub_cap);
+    a->dq=(ov_idx_t*)realloc(a->dq,sizeof(ov_idx_t)*a->sub_cap);
+  }
+  sub->size=0;
+  sub->elms_size=0;
+  for(k=0;k<nt;k++) {
+    ov_idx_t s;
+    for(s=a->comp_first[a->touched[k]];s>=0;s=a->set_next[s]) {
+      a->gid[sub->size]=s;
+      family_add_set(sub,f->sets.size[s],family_set(f,s));
+    }
+  }
+  for(i=first;i<f->size;i++) {
+    a->gid[sub->size]=i;
+    family_add_set(sub,f->sets.size[i],family_set(f,i));
+  }
+  /* the sets of the component q of 'sub' are gid[grp.sets[grp.off[q]..]] */
+  p=compute_overlap_groups_ctx(a->ctx,sub,&a->grp);
+
+  /* a component takes the smallest identifier of the old components it 
+     contains (or a new one), the others are dead */
+  for(q=0;q<p;q++) {
+    ov_idx_t d=-1;
+    for(k=a->grp.off[q];k<a->grp.off[q+1];k++) {
+      ov_idx_t l=a->label[a->gid[a->grp.sets[k]]];
+      if(l>=0 && (d<0 || l<d)) d=l;
+    }
+    if(d<0) d=incr_new_comp(a);
+    a->dq[q]=d;
+    for(k=a->grp.off[q];k<a->grp.off[q+1];k++) {
+      ov_idx_t l=a->label[a->gid[a->grp.sets[k]]];
+      if(l>=0 && l!=d) a->dead[l]=1;
+    }
+  }
+
+  /* new labels, lists of sets and lists of the elements */
+  for(q=0;q<p;q++) {
+    ov_idx_t d=a->dq[q];
+    a->comp_first[d]=-1;
+    a->comp_size[d]=overlap_group_size(&a->grp,q);
+    a->now++;
+    for(k=a->grp.off[q];k<a->grp.off[q+1];k++) {
+      ov_idx_t s=a->gid[a->grp.sets[k]];
+      const int *set=family_set(f,s);
+      a->label[s]=d;
+      a->set_next[s]=a->comp_first[d];
+      a->comp_first[d]=s;
+      for(j=0;j<f->sets.size[s];j++)
+	if(a->stamp[set[j]]!=a->now) {
+	  a->stamp[set[j]]=a->now;
+	  incr_update_elm(a,set[j],d);
+	}
+    }
+  }
+
+  a->ncomp+=p-nt;
+  return a->ncomp;
+}
+
+/**
+ * Put the components into 't' (indiced as a->f.sets), numbered from 1 
+ * in the order of their smallest set.
+ * Returns the number of components.
+ * Time: O(a->f.size + a->ncomp_ids)
+ */
+ov_idx_t incr_labels(const incr_t *a,ov_idx_t *t)
+{
+  ov_idx_t i,p=0;
+  ov_idx_t *num=(ov_idx_t*)calloc(a->ncomp_ids>0?a->ncomp_ids:1,sizeof(ov_idx_t));
+  for(i=0;i<a->f.size;i++) {
+    if(num[a->label[i]]==0) num[a->label[i]]=++p;
+    t[i]=num[a->label[i]];
+  }
+  free(num);
+  return p;
+}
@@ -0,0 +1,69 @@
+/*
+ *   This source file is part of program computing set overlap classes 
+ *   in linear time.
+ *   Copyright (C) 2007  Michael Rao
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _INCR_H_
+#define _INCR_H_
+
+#include "overlap.h"
+
+/**
+ * Overlap components maintained while sets are added.
+ * label[i] is the component of the i-th added set. Components are 
+ * identified by integers < ncomp_ids, which are not consecutive: when 
+ * components are merged, the new component takes the smallest of their 
+ * identifiers.
+ */
+typedef struct {
+  family_t f; /* all the sets, in order of insertion (never sorted) */
+  overlap_ctx_t *ctx;
+
+  ov_idx_t *label; /* component of every set */
+  ov_idx_t ncomp; /* number of components */
+
+  ov_idx_t *set_next; /* next set in the same component, or -1 */
+  ov_idx_t set_cap; /* allocated size of 'label' and 'set_next' */
+
+  /* components */
+  ov_idx_t ncomp_ids,comp_cap;
+  ov_idx_t *comp_first; /* first set of the component */
+  ov_idx_t *comp_size; /* number of sets of the component */
+  int *dead; /* 1 if the component was merged into another one */
+  int *comp_stamp; /* marks on the components */
+
+  /* el[e][0..el_len[e]-1] are the components whose union contains 'e' */
+  ov_idx_t **el;
+  ov_idx_t *el_len,*el_cap;
+  int *stamp; /* marks on the elements */
+  int now; /* current mark */
+
+  /* scratch tables */
+  family_t sub; /* the sets being recomputed */
+  ov_idx_t *gid; /* set of 'f' of every set of 'sub' */
+  overlap_groups_t grp; /* components of 'sub' */
+  ov_idx_t *dq;
+  ov_idx_t sub_cap; /* allocated size of the tables above */
+  ov_idx_t *touched; /* comp_cap entries */
+} incr_t;
+
+extern void incr_create(incr_t *a,int grnd_size);
+extern void incr_free(incr_t *a);
+extern ov_idx_t incr_add_sets(incr_t *a,ov_idx_t nbr,const ov_idx_t *offsets,const int *elms);
+extern ov_idx_t incr_labels(const incr_t *a,ov_idx_t *t);
+
+#endif
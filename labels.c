@@ -0,0 +1,193 @@
+/*
+ *   This source file is part of program computing set overlap classes 
+ *   in linear time.
+ *   Copyright (C) 2007  Michael Rao
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include "labels.h"
+
+/*
+ * Output of the component labels, through a large buffer written with
+ * write(2). The integers are formatted by hand. In the CSR mode, the 
+ * output is itself a family in the text format (see famio.c), on the
+ * ground set of the sets: the sets are given by their identifier (order 
+ * in the input), in increasing order in a component, and the components
+ * in the order of their smallest identifier (see overlap_groups_build).
+ */
+
+#define LABELS_BLOCK (1<<20) /* size of the output buffer */
+
+static const char *labels_name[]={"none","text","bin","csr","summary"};
+
+/**
+ * Buffered output on a file descriptor
+ */
+typedef struct {
+  int fd;
+  char *buf;
+  size_t len;
+  int err;
+} labels_out_t;
+
+/* write 'n' bytes of 'b', even if write(2) writes less */
+static void labels_raw(labels_out_t *o,const char *b,size_t n)
+{
+  while(n>0 && !o->err) {
+    ssize_t r=write(o->fd,b,n);
+    if(r<0) {
+      if(errno!=EINTR) o->err=1;
+    } else {
+      b+=r;
+      n-=(size_t)r;
+    }
+  }
+}
+
+static void labels_flush(labels_out_t *o)
+{
+  labels_raw(o,o->buf,o->len);
+  o->len=0;
+}
+
+/* append the string 's' (shorter than 64 characters) */
+static void labels_str(labels_out_t *o,const char *s)
+{
+  size_t n=strlen(s);
+  if(o->len+n>LABELS_BLOCK)
+    labels_flush(o);
+  memcpy(o->buf+o->len,s,n);
+  o->len+=n;
+}
+
+/* append the integer 'v' and the character 'sep' */
+static void labels_int(labels_out_t *o,long long v,char sep)
+{
+  char d[24];
+  int k=0;
+  unsigned long long u=v<0?-(unsigned long long)v:(unsigned long long)v;
+  if(o->len+sizeof(d)+2>LABELS_BLOCK)
+    labels_flush(o);
+  if(v<0) o->buf[o->len++]='-';
+  do {
+    d[k++]=(char)('0'+u%10);
+    u/=10;
+  } while(u);
+  while(k) o->buf[o->len++]=d[--k];
+  o->buf[o->len++]=sep;
+}
+
+/**
+ * Returns the mode of the name 'name' ("none", "text", "bin", "csr" or
+ * "summary"), or -1
+ */
+int labels_mode(const char *name)
+{
+  int i;
+  for(i=0;i<(int)(sizeof(labels_name)/sizeof(labels_name[0]));i++)
+    if(strcmp(name,labels_name[i])==0)
+      return i;
+  return -1;
+}
+
+/**
+ * Write the labels 't' of the sets of 'f', numbered from 1 to 'nc' and
+ * indiced as f->sets (see compute_overlap_components), in 'file'
+ * ("-" is the standard output, which is flushed first) in the mode 'mode'
+ * (see labels.h). In every mode the sets are given in the order of their
+ * identifiers (f->sets.id), and the components are numbered in the order 
+ * of their smallest identifier.
+ * Returns 0, or -1 on error.
+ * Time: O(f->size+nc)
+ */
+int labels_write(const char *file,int mode,const family_t *f,const ov_idx_t *t,ov_idx_t nc)
+{
+  labels_out_t o;
+  overlap_groups_t g;
+  ov_idx_t i,q,n=f->size;
+
+  if(mode==LABELS_NONE) return 0;
+  if(strcmp(file,"-")==0) {
+    fflush(stdout);
+    o.fd=1;
+  } else if((o.fd=open(file,O_WRONLY|O_CREAT|O_TRUNC,0666))<0)
+    return -1;
+  o.len=0;
+  o.err=0;
+
+  /* the sets of every component, by identifier */
+  overlap_groups_init(&g);
+  overlap_groups_build(&g,f,t,nc);
+
+  if(mode==LABELS_BIN) {
+    /* one write of the whole table */
+    int *b=(int*)malloc(sizeof(int)*(size_t)(n>0?n:1));
+    o.buf=(char*)b;
+    if(nc>0x7fffffff) {
+      errno=EOVERFLOW;
+      o.err=1;
+    } else {
+      for(q=0;q<nc;q++)
+	for(i=g.off[q];i<g.off[q+1];i++)
+	  b[g.sets[i]]=(int)(q+1);
+      labels_raw(&o,o.buf,sizeof(int)*(size_t)n);
+    }
+  } else {
+    o.buf=(char*)malloc(LABELS_BLOCK);
+    if(mode==LABELS_TEXT) {
+      ov_idx_t *lab=(ov_idx_t*)malloc(sizeof(ov_idx_t)*(size_t)(n>0?n:1));
+      for(q=0;q<nc;q++)
+	for(i=g.off[q];i<g.off[q+1];i++)
+	  lab[g.sets[i]]=q+1;
+      for(i=0;i<n;i++)
+	labels_int(&o,lab[i],' ');
+      labels_str(&o,"\n");
+      free(lab);
+    } else if(mode==LABELS_CSR) {
+      for(q=0;q<nc;q++) {
+	for(i=g.off[q];i<g.off[q+1];i++)
+	  labels_int(&o,g.sets[i],' ');
+	labels_int(&o,-1,'\n');
+      }
+    } else {
+      /* histogram of the sizes of the components */
+      ov_idx_t *cnt=(ov_idx_t*)calloc((size_t)n+1,sizeof(ov_idx_t));
+      for(q=0;q<nc;q++)
+	cnt[overlap_group_size(&g,q)]++;
+      labels_int(&o,nc,' ');
+      labels_str(&o,"components\n");
+      for(i=1;i<=n;i++)
+	if(cnt[i]) {
+	  labels_int(&o,i,' ');
+	  labels_int(&o,cnt[i],'\n');
+	}
+      free(cnt);
+    }
+    labels_flush(&o);
+  }
+
+  overlap_groups_free(&g);
+  free(o.buf);
+  if(o.fd!=1 && close(o.fd)<0) 
+    o.err=1;
+  return o.err?-1:0;
+}
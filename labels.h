@@ -0,0 +1,36 @@
+/*
+ *   This source file is part of program computing set overlap classes 
+ *   in linear time.
+ *   Copyright (C) 2007  Michael Rao
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef _LABELS_H_
+#define _LABELS_H_
+
+#include "overlap.h"
+
+/*
+ * Output modes of the component labels (see labels_write)
+ */
+#define LABELS_NONE 0
+#define LABELS_TEXT 1 /* the labels, separated by spaces, on one line */
+#define LABELS_BIN 2 /* the labels as raw int32, in native byte order */
+#define LABELS_CSR 3 /* one line per component: the identifiers of its sets, ended by -1 */
+#define LABELS_SUMMARY 4 /* "nc components", then lines "size number" */
+
+extern int labels_mode(const char *name);
+extern int labels_write(const char *file,int mode,const family_t *f,const ov_idx_t *t,ov_idx_t nc);
+
+#endif
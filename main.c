@@ -19,188 +19,395 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include "overlap.h"
 #include "test.h"
 #include "gen.h"
+#include "cc.h"
+#include "famio.h"
+#include "batch.h"
+#include "incr.h"
+#include "prepass.h"
+#include "blocks.h"
+#include "cert.h"
+#include "labels.h"
+
+/**
+ * Options of the program
+ */
+typedef struct {
+  int printgraph;
+  int labels; /* output mode of the labels (see labels.h) */
+  const char *out; /* file of the labels */
+  int check;
+  int nthreads;
+  int binary;
+  int sparse;
+  int batch;
+  int incr; /* size of the batches of the incremental engine, or 0 */
+  int prepass;
+  int blocks;
+  int cert;
+  int gen; /* generate with the parallel generator */
+  int engine; /* engine of the components (see overlap.h) */
+  int verify; /* compare the components of the Dahlhaus graph and the subgraph */
+} main_opt_t;
+
+/**
+ * Builds the graph of 'engine' (OVERLAP_ENGINE_DAHLHAUS or
+ * OVERLAP_ENGINE_SUBGRAPH) once compute_max has been called on 'f', and
+ * puts its connected components in 'cc'.
+ * Returns the number of components.
+ * Time: O(f->size + \sum_i f->set[i].size)
+ */
+static ov_idx_t graph_components(overlap_ctx_t *ctx,const family_t *f,int engine,const main_opt_t *o,ov_idx_t *cc)
+{
+  graph_t g;
+  ov_idx_t nc;
+
+  if(engine==OVERLAP_ENGINE_DAHLHAUS) {
+    printf("++ Dahlhaus graph ++\n");
+    graph_dahlhaus_create_ctx(ctx,&g,f);
+  } else {
+    printf("++ A subgraph of the overlap graph ++\n");
+    graph_subgraph_overlap_create_ctx(ctx,&g,f);
+  }
+
+  if(o->printgraph) {
+    printf("Graph:\n");
+    graph_print(&g);
+  }
 
-int printgraph=0;
-int printCC=1;
-int check=0;
+  nc=graph_connected_components_parallel(&g,cc,o->nthreads);
+  graph_free(&g);
+  return nc;
+}
+
+/**
+ * The engine named 'name' (uf, dahlhaus or subgraph), or -1
+ */
+static int engine_of(const char *name)
+{
+  if(strcmp(name,"uf")==0) return OVERLAP_ENGINE_UF;
+  if(strcmp(name,"dahlhaus")==0) return OVERLAP_ENGINE_DAHLHAUS;
+  if(strcmp(name,"subgraph")==0) return OVERLAP_ENGINE_SUBGRAPH;
+  return -1;
+}
+
+static void usage(const char *prg)
+{
+  printf("usage: '%s [options] file' or '%s [options] size_grnd seed'\n"
+	 "('-' is the standard input)\n"
+	 "options:\n"
+	 "  -j n : use n threads to read the file and for the connected components\n"
+	 "  -e e : engine of the components: uf (default; union-find on the\n"
+	 "         edges of the Dahlhaus graph, no graph is built), dahlhaus\n"
+	 "         (Dahlhaus graph) or subgraph (a subgraph of the overlap graph)\n"
+	 "  -V   : verify mode: compute the components with both the Dahlhaus\n"
+	 "         graph and the subgraph, and compare them (-e is ignored)\n"
+	 "  -L m : output mode of the labels of the sets: text (default), bin\n"
+	 "         (raw int32), csr (sets of each component), summary (number\n"
+	 "         of components by size) or none\n"
+	 "  -O f : write the labels in the file f (default: standard output)\n"
+	 "  -G   : generate the family with the parallel generator (with the\n"
+	 "         -j threads; the family does not depend on their number)\n"
+	 "  -b   : the file is in the binary format (see txt2bin)\n"
+	 "  -s   : the elements are any integers < 2^64 (they are renumbered)\n"
+	 "  -B   : the file is a batch of families, each one ended by -2;\n"
+	 "         they are computed by the -j threads, and their components\n"
+	 "         are written in input order (only with -L text or none,\n"
+	 "         and without -O)\n"
+	 "  -I n : also add the sets by batches of n to the incremental\n"
+	 "         engine, and compare its components\n"
+	 "  -P   : also compute the components after removing the equal sets,\n"
+	 "         and the sets of size 1 or grnd_size, and compare them\n"
+	 "  -D   : also compute the components block by block (independent\n"
+	 "         parts of the ground set) with the -j threads, and compare\n"
+	 "  -C   : also compute the components with a certificate (witnesses\n"
+	 "         of a spanning forest), check it and compare\n"
+	 "  -c   : also compute the complete overlap graph with the -j threads\n"
+	 "         (quadratic), and compare its components\n",prg,prg);
+  exit(1);
+}
 
 int main(int argc, char **argv)
 {
   family_t f;
-  FILE *in;
-  int max=-1;
-  int *set;
-  int sm=-1;
-  int ts=0;
-  int *cc1=NULL,*cc2=NULL;
-  int nc1,nc2;
-  int i,S=0;
-
-  if(argc<=1 || argc >3) {
-    printf("usage: '%s file' or '%s size_grnd seed'\n",argv[0],argv[0]);
-    exit(1);
+  famio_map_t map={NULL,0};
+  overlap_ctx_t *ctx;
+  ov_idx_t *cc1=NULL,*cc2=NULL;
+  ov_idx_t nc1,nc2;
+  ov_idx_t i,S=0;
+  char *prg=argv[0];
+  main_opt_t o={0,LABELS_TEXT,"-",0,1,0,0,0,0,0,0,0,0,OVERLAP_ENGINE_UF,0};
+  remap_t rm;
+
+  while(argc>1 && argv[1][0]=='-' && argv[1][1]) {
+    if(strcmp(argv[1],"-j")==0 && argc>2) {
+      o.nthreads=atoi(argv[2]);
+      argc--; argv++;
+    } else if(strcmp(argv[1],"-L")==0 && argc>2) {
+      if((o.labels=labels_mode(argv[2]))<0)
+	usage(prg);
+      argc--; argv++;
+    } else if(strcmp(argv[1],"-O")==0 && argc>2) {
+      o.out=argv[2];
+      argc--; argv++;
+    } else if(strcmp(argv[1],"-e")==0 && argc>2) {
+      if((o.engine=engine_of(argv[2]))<0)
+	usage(prg);
+      argc--; argv++;
+    } else if(strcmp(argv[1],"-V")==0) {
+      o.verify=1;
+    } else if(strcmp(argv[1],"-G")==0) {
+      o.gen=1;
+    } else if(strcmp(argv[1],"-b")==0) {
+      o.binary=1;
+    } else if(strcmp(argv[1],"-s")==0) {
+      o.sparse=1;
+    } else if(strcmp(argv[1],"-B")==0) {
+      o.batch=1;
+    } else if(strcmp(argv[1],"-P")==0) {
+      o.prepass=1;
+    } else if(strcmp(argv[1],"-D")==0) {
+      o.blocks=1;
+    } else if(strcmp(argv[1],"-C")==0) {
+      o.cert=1;
+    } else if(strcmp(argv[1],"-c")==0) {
+      o.check=1;
+    } else if(strcmp(argv[1],"-I")==0 && argc>2) {
+      o.incr=atoi(argv[2]);
+      argc--; argv++;
+    } else 
+      usage(prg);
+    argc--; argv++;
+  }
+
+  if(argc<=1 || argc >3)
+    usage(prg);
+
+  if(o.batch) {
+    famio_batch_t b;
+    if(argc!=2 || strcmp(o.out,"-")!=0 
+       || (o.labels!=LABELS_TEXT && o.labels!=LABELS_NONE))
+      usage(prg);
+    if(famio_read_batch(&b,argv[1])<0) {
+      perror("cannot read batch file\n");
+      exit(1);
+    }
+    if(batch_run(&b,o.nthreads,(o.labels!=LABELS_NONE),stdout)<0) {
+      perror("cannot write the results\n");
+      exit(1);
+    }
+    famio_batch_free(&b);
+    return 0;
   }
 
   if(argc==3) {
     int grnd=atoi(argv[1]);
     printf("++ Generate the family ++\n");
     family_create(&f,grnd);
-    family_gen(&f,grnd,30,0.05,atoi(argv[2]));
-  } else {
-    /* read the family in a file */
-    printf("++ Read the family ++\n");
-
-    if((in=fopen(argv[1],"r"))==NULL) {
-      perror("cannot open file\n");
+    if(!o.gen)
+      family_gen(&f,grnd,30,0.05,atoi(argv[2]));
+    else if(family_gen_parallel(&f,grnd,30,0.05,atoi(argv[2]),o.nthreads)<0) {
+      perror("cannot generate the family\n");
       exit(1);
     }
-
-    /* compute size of the ground set
-       we suppose that every element < max is used
-       compute also the size max of a set */
-    ts=0;
-    while(!feof(in)) {
-      char buff[1000];
-      fscanf(in,"%s",buff);
-      if(atoi(buff)>=0) {
-          if(atoi(buff)>max) max=atoi(buff);
-          ts++;
-      } else {
-          if(ts>sm) sm=ts;
-          ts=0;
-      }
+  } else if(o.binary) {
+    printf("++ Map the family ++\n");
+    if(family_map_bin(&f,&map,argv[1])<0) {
+      perror("cannot map binary family file\n");
+      exit(1);
     }
-
-    set=(int*)malloc(sizeof(int)*sm);
-
-    fclose(in);
-
-    family_create(&f,max+1);
-
-    if((in=fopen(argv[1],"r"))==NULL) {
-      perror("cannot open file\n");
+  } else if(o.sparse) {
+    printf("++ Read the family (sparse elements) ++\n");
+    if(family_read_txt_sparse(&f,&rm,argv[1])<0) {
+      perror("cannot read file\n");
       exit(1);
     }
-
-    ts=0;
-    while(!feof(in)) {
-      char buff[1000];
-      fscanf(in,"%s",buff);
-      if(atoi(buff)>=0) {
-	set[ts]=atoi(buff);
-	ts++;
-      } else {
-	if(ts>0) {
-	  family_add_set(&f,ts,set);
-	}
-	ts=0;
-      }
+  } else {
+    /* read the family in a file */
+    printf("++ Read the family ++\n");
+    if(family_read_txt(&f,argv[1],o.nthreads)<0) {
+      perror("cannot read file\n");
+      exit(1);
     }
-
-    free(set);
-    fclose(in);
   }
 
   S=0;
   for(i=0;i<f.size;i++)
-    S+=f.sets[i].size;
+    S+=f.sets.size[i];
   printf("++ Ground set: %d\n"
-	 "++ Number of sets in the family: %d\n"
-	 "++ \\sum_i |X_i| = %d\n",f.grnd_size,f.size,S);
-
-  compute_max(&f);
+	 "++ Number of sets in the family: %lld\n"
+	 "++ \\sum_i |X_i| = %lld\n",f.grnd_size,(long long)f.size,(long long)S);
+
+  /* the scratch tables are shared by all the computations */
+  ctx=overlap_ctx_create();
+  overlap_ctx_set_threads(ctx,o.nthreads);
+
+  cc1=(ov_idx_t*)malloc(sizeof(ov_idx_t)*(size_t)(f.size+1));
+  if(o.verify) {
+    /* both graphs are built from the same Maxs */
+    cc2=(ov_idx_t*)malloc(sizeof(ov_idx_t)*(size_t)(f.size+1));
+    compute_max_ctx(ctx,&f);
+    nc1=graph_components(ctx,&f,OVERLAP_ENGINE_DAHLHAUS,&o,cc1);
+    nc2=graph_components(ctx,&f,OVERLAP_ENGINE_SUBGRAPH,&o,cc2);
+  } else if(o.engine==OVERLAP_ENGINE_UF) {
+    printf("++ Union-find on the Dahlhaus edges ++\n");
+    nc1=compute_overlap_components_ctx(ctx,&f,cc1);
+  } else {
+    compute_max_ctx(ctx,&f);
+    nc1=graph_components(ctx,&f,o.engine,&o,cc1);
+  }
 
-  {
-    graph_t g;
-    printf("++ Dahlhaus graph ++\n");
-    graph_dahlhaus_create(&g,&f);
+  printf("++ %lld connected components ++\n",(long long)nc1);
 
-    if(printgraph) {
-      printf("Graph:\n");
-      graph_print(&g);
+  if(o.verify) {
+    for(i=0;i<f.size;i++) {
+      if(nc2!=nc1 || cc2[i]!=cc1[i]) {
+	printf("++ Something bad happens...\n");
+	/*family_print(&f);*/
+	exit(1);
+      }
     }
+  }
 
-    cc1=(int*)malloc(sizeof(int)*g.n);
-    nc1=graph_connected_components(&g,cc1);
-
-    if(printCC) {
-      printf("Connected components:\n");
-      for(i=0;i<g.n;i++)
-	printf("%d ",cc1[i]);
-      printf("\n");
-    }
-    graph_free(&g);
+  if(o.labels==LABELS_TEXT && strcmp(o.out,"-")==0)
+    printf("Connected components:\n");
+  if(labels_write(o.out,o.labels,&f,cc1,nc1)<0) {
+    perror("cannot write the labels\n");
+    exit(1);
   }
 
-  family_clear(&f);
+  if(o.prepass) {
+    ov_idx_t *lab=(ov_idx_t*)malloc(sizeof(ov_idx_t)*(size_t)(f.size+1));
+    ov_idx_t *num=(ov_idx_t*)calloc((size_t)nc1+1,sizeof(ov_idx_t));
+    prepass_stats_t st;
+    ov_idx_t ncp=prepass_components(ctx,&f,lab,&st);
 
-  compute_max(&f);
+    printf("++ Prepass: %lld sets kept, %lld equal sets, %lld sets aside ++\n",
+	   (long long)st.nsets,(long long)st.ndup,(long long)st.naside);
+    for(i=0;i<f.size;i++) {
+      ov_idx_t x=lab[f.sets.id[i]];
+      if(num[cc1[i]]==0) num[cc1[i]]=x;
+      if(ncp!=nc1 || num[cc1[i]]!=x) {
+	printf("++ Something bad happens with the prepass...\n");
+	exit(1);
+      }
+    }
+    free(lab);
+    free(num);
+  }
 
-  {
-    graph_t g;
-    printf("++ A subgraph of the overlap graph ++\n");
-    graph_subgraph_overlap_create(&g,&f);
+  if(o.blocks) {
+    ov_idx_t *lab=(ov_idx_t*)malloc(sizeof(ov_idx_t)*(size_t)(f.size+1));
+    ov_idx_t *num=(ov_idx_t*)calloc((size_t)nc1+1,sizeof(ov_idx_t));
+    ov_idx_t nb,ncb=blocks_components(&f,lab,o.nthreads,&nb);
 
-    if(printgraph) {
-      printf("Graph:\n");
-      graph_print(&g);
+    if(ncb<0) {
+      perror("cannot compute the blocks\n");
+      exit(1);
+    }
+    printf("++ %lld independent blocks ++\n",(long long)nb);
+    for(i=0;i<f.size;i++) {
+      ov_idx_t x=lab[f.sets.id[i]];
+      if(num[cc1[i]]==0) num[cc1[i]]=x;
+      if(ncb!=nc1 || num[cc1[i]]!=x) {
+	printf("++ Something bad happens with the blocks...\n");
+	exit(1);
+      }
     }
+    free(lab);
+    free(num);
+  }
 
-    cc2=(int*)malloc(sizeof(int)*g.n);
-    nc2=graph_connected_components(&g,cc2);
+  if(o.cert) {
+    ov_idx_t *lab=(ov_idx_t*)malloc(sizeof(ov_idx_t)*(size_t)(f.size+1));
+    overlap_cert_t *cert=(overlap_cert_t*)malloc(sizeof(overlap_cert_t)*(size_t)(f.size+1));
+    ov_idx_t ncc=compute_overlap_certificates_ctx(ctx,&f,lab,cert);
 
-    if(printCC) {
-      printf("Connected components:\n");
-      for(i=0;i<g.n;i++)
-	printf("%d ",cc2[i]);
-      printf("\n");
+    printf("++ Certificate: %lld edges ++\n",(long long)(f.size-ncc));
+    if(!overlap_cert_check(&f,lab,ncc,cert)) {
+      printf("++ Something bad happens with the certificate...\n");
+      exit(1);
     }
-    graph_free(&g);
+    for(i=0;i<f.size;i++) {
+      if(ncc!=nc1 || lab[i]!=cc1[i]) {
+	printf("++ Something bad happens with the certificate...\n");
+	exit(1);
+      }
+    }
+    free(lab);
+    free(cert);
   }
 
-  printf("++ %d connected components ++\n",nc1);
+  if(o.incr>0) {
+    /* the sets are added in input order, by batches of o.incr */
+    incr_t a;
+    ov_idx_t *off=(ov_idx_t*)malloc(sizeof(ov_idx_t)*(size_t)(f.size+1));
+    ov_idx_t *pos=(ov_idx_t*)malloc(sizeof(ov_idx_t)*(size_t)(f.size+1));
+    int *elms=(int*)malloc(sizeof(int)*(size_t)(S>0?S:1));
+    ov_idx_t *lab=(ov_idx_t*)malloc(sizeof(ov_idx_t)*(size_t)(f.size+1));
+    ov_idx_t *num=(ov_idx_t*)calloc((size_t)nc1+1,sizeof(ov_idx_t));
+    ov_idx_t nci=0;
+
+    printf("++ Incremental engine, by %d sets ++\n",o.incr);
+    for(i=0;i<f.size;i++)
+      pos[f.sets.id[i]]=i;
+    off[0]=0;
+    for(i=0;i<f.size;i++) {
+      ov_idx_t s=pos[i];
+      memcpy(elms+off[i],family_set(&f,s),sizeof(int)*(size_t)f.sets.size[s]);
+      off[i+1]=off[i]+f.sets.size[s];
+    }
+    incr_create(&a,f.grnd_size);
+    for(i=0;i<f.size;i+=o.incr)
+      nci=incr_add_sets(&a,i+o.incr<f.size?o.incr:f.size-i,off+i,elms);
+    incr_labels(&a,lab);
 
-  for(i=0;i<f.size;i++) {
-    if(cc2[i]!=cc1[i]) {
-      printf("++ Something bad happens...\n");
-      /*family_print(&f);*/
-      exit(1);
+    /* same partition: the same number of components, and the components 
+       of cc1 are in one component of 'lab' */
+    for(i=0;i<f.size;i++) {
+      ov_idx_t x=lab[f.sets.id[i]];
+      if(num[cc1[i]]==0) num[cc1[i]]=x;
+      if(nci!=nc1 || num[cc1[i]]!=x) {
+	printf("++ Something bad happens with the incremental engine...\n");
+	exit(1);
+      }
     }
+    incr_free(&a);
+    free(off);
+    free(pos);
+    free(elms);
+    free(lab);
+    free(num);
   }
 
-  if(check) {
-    /* computes the overlap graph by a simple, naive, non polynomial algorithm
+  if(o.check) {
+    /* computes the complete overlap graph by a simple, quadratic algorithm
      * only for debug */
     graph_t g;
-    int *cco;
+    ov_idx_t *cco;
 
     printf("++ Overlap graph ++\n");
-    graph_overlap_create(&g,&f);
+    graph_overlap_create_parallel(&g,&f,o.nthreads);
 
-    if(printgraph) {
+    if(o.printgraph) {
       printf("Graph:\n");
       graph_print(&g);
     }
 
-    cco=(int*)malloc(sizeof(int)*g.n);
-    graph_connected_components(&g,cco);
-
-    if(printCC) {
-      printf("Connected components:\n");
-      for(i=0;i<g.n;i++)
-	printf("%d ",cco[i]);
-      printf("\n");
-    }
-
+    cco=(ov_idx_t*)malloc(sizeof(ov_idx_t)*(size_t)g.n);
+    graph_connected_components_ctx(ctx,&g,cco);
     graph_free(&g);
 
     for(i=0;i<f.size;i++) {
       if(cco[i]!=cc1[i]) {
 	printf("++ Something bad happens... ++\n");
-	family_print(&f);
+	if(o.sparse)
+	  family_print_sparse(&f,&rm);
+	else
+	  family_print(&f);
 	exit(1);
       }
     }
@@ -208,7 +415,11 @@ int main(int argc, char **argv)
     free(cco);
   }
 
+  overlap_ctx_free(ctx);
   family_free(&f);
+  famio_unmap(&map);
+  if(o.sparse)
+    remap_free(&rm);
 
   free(cc1);
   free(cc2);
@@ -17,15 +17,376 @@
  *   along with this program. If not, see <http://www.gnu.org/licenses/>.
  */
 
+#define _POSIX_C_SOURCE 200809L
+
 #include <stdio.h>
 #include <stdlib.h>
 #include <assert.h>
+#include <time.h>
+#include <pthread.h>
 #include "overlap.h"
+#include "uf.h"
 
 /*
 #define DEBUG
 */
 
+const char *overlap_phase_name[PH_NBR]={
+  "family_sort","refine1","leftright","am_create","refine2",
+  "sl_index","dahlhaus","subgraph","graph_sort","uf","cc"
+};
+
+/**
+ * Returns a wall-clock time in seconds 
+ */
+double overlap_time(void)
+{
+  struct timespec t;
+  clock_gettime(CLOCK_MONOTONIC,&t);
+  return t.tv_sec+1e-9*t.tv_nsec;
+}
+
+/*
+ * Instrumentation counters: compiled only with -DOVERLAP_STATS.
+ * STAT_ADD adds to a counter, STAT_PHASE sets the phase to which 
+ * allocations are charged, OV_MALLOC and OV_REALLOC count allocations.
+ */
+#ifdef OVERLAP_STATS
+
+const int overlap_stats_enabled=1;
+
+#define STAT_ADD(s,field,v) do { if(s) (s)->field+=(v); } while(0)
+#define STAT_PHASE(s,ph) do { if(s) (s)->phase=(ph); } while(0)
+#define OV_MALLOC(s,n) stats_malloc((s),(n))
+#define OV_REALLOC(s,p,n) stats_realloc((s),(p),(n))
+
+static void *stats_malloc(overlap_stats_t *s,size_t n)
+{
+  if(s) {
+    s->allocs[s->phase]++;
+    s->bytes[s->phase]+=n;
+  }
+  return malloc(n);
+}
+
+static void *stats_realloc(overlap_stats_t *s,void *p,size_t n)
+{
+  if(s) {
+    s->allocs[s->phase]++;
+    s->bytes[s->phase]+=n;
+  }
+  return realloc(p,n);
+}
+
+#else
+
+const int overlap_stats_enabled=0;
+
+#define STAT_ADD(s,field,v)
+#define STAT_PHASE(s,ph)
+#define OV_MALLOC(s,n) malloc(n)
+#define OV_REALLOC(s,p,n) realloc((p),(n))
+
+#endif
+
+/**
+ * Add the time since '*t' to the phase 'ph', and reset '*t'.
+ * Nothing is done if 's' is NULL.
+ */
+static void stats_phase(overlap_stats_t *s,int ph,double *t)
+{
+  double t2;
+  if(s==NULL) return;
+  t2=overlap_time();
+  s->time[ph]+=t2-*t;
+  *t=t2;
+}
+
+
+/*
+ * Context: the scratch tables of the algorithms.
+ * They only grow, so the functions taking a context can be called
+ * back-to-back without allocating anything but their results.
+ */
+
+/* scratch tables of a context */
+enum {
+  CTX_LOC, /* local indice of the elements of the ground set, or -1 */
+  CTX_GLOB, /* element of the ground set of the local indices */
+  CTX_LSTART, CTX_LELMS, /* the family with local indices, in CSR form */
+  CTX_COUNT, /* grnd_count of the families created by family_create_ctx */
+  CTX_CSORT_POS, CTX_CSORT_CNT, /* counting_sort */
+  CTX_SRT_KEY, CTX_SRT_OFF, CTX_SRT_PERM, CTX_SETS, CTX_ELMS, /* family_sort */
+  CTX_REF_T, CTX_REF_IND, CTX_CLASSES, CTX_HIT, /* refine structure */
+  CTX_AM_T, CTX_AM_TI, CTX_AM_KEY, CTX_AM_OFF, CTX_AM_PERM, CTX_AM_SRT, /* AM structure */
+  CTX_SL_OFF, CTX_SL_SET, /* SL index (see sl_get) */
+  CTX_Q, CTX_QL, CTX_QR, /* quintuples */
+  CTX_PREV, CTX_SMAX, /* dahlhaus_edges */
+  CTX_EDGES, CTX_CNT, CTX_BEG, CTX_POS, CTX_SRC, /* graph_sort */
+  CTX_STACK, CTX_UF, /* connected components */
+  CTX_GRP_T, CTX_GRP_LAB, CTX_GRP_NUM, /* groups of sets by component */
+  CTX_MARK, CTX_CERT_UF, CTX_CERT_PIECES, /* certificates */
+  CTX_CERT_SETS, CTX_CERT_IDX, CTX_CERT_LIST, CTX_CERT_CO, CTX_CERT_TOUCH,
+  CTX_CERT_SMALL, CTX_CERT_LARGE, CTX_CERT_OFF, CTX_CERT_ORDER,
+  CTX_NBR
+};
+
+struct overlap_ctx_s {
+  void *buf[CTX_NBR];
+  size_t cap[CTX_NBR]; /* allocated size of buf[i], in bytes */
+  int nthreads; /* threads of the histograms of counting_sort */
+
+  /* the ground set used by the family being processed (see ctx_load) */
+  int k; /* number of elements */
+  int *loc,*glob;
+  ov_idx_t *lstart;
+  int *lelms;
+
+  /* the family of the SL index in CTX_SL_OFF and CTX_SL_SET, or NULL */
+  const family_t *sl_f;
+  unsigned long sl_stamp; /* f->stamp when it was built */
+};
+
+/* the table of local elements of the i-th set */
+#define ctx_set(c,i) ((c)->lelms+(c)->lstart[i])
+
+overlap_ctx_t *overlap_ctx_create(void)
+{
+  overlap_ctx_t *c=(overlap_ctx_t*)malloc(sizeof(overlap_ctx_t));
+  int i;
+  for(i=0;i<CTX_NBR;i++) {
+    c->buf[i]=NULL;
+    c->cap[i]=0;
+  }
+  c->nthreads=1;
+  c->k=0;
+  c->loc=c->glob=c->lelms=NULL;
+  c->lstart=NULL;
+  c->sl_f=NULL;
+  return c;
+}
+
+void overlap_ctx_free(overlap_ctx_t *c)
+{
+  int i;
+  if(c==NULL) return;
+  for(i=0;i<CTX_NBR;i++)
+    free(c->buf[i]);
+  free(c);
+}
+
+/**
+ * Set the number of threads used by the histograms of the counting sorts
+ * of 'c' (1 by default). They only run on large inputs.
+ */
+void overlap_ctx_set_threads(overlap_ctx_t *c,int nthreads)
+{
+  c->nthreads=nthreads>1?nthreads:1;
+}
+
+/**
+ * Returns the table 'slot' of 'c' with room for 'n' items of 'size' bytes.
+ * The table grows geometrically and keeps its content.
+ * Time: O(1) amortized
+ */
+static void *ctx_buf(overlap_ctx_t *c,int slot,size_t n,size_t size,overlap_stats_t *s)
+{
+  size_t need=(n>0?n:1)*size;
+  if(need>c->cap[slot]) {
+    size_t cap=2*c->cap[slot];
+    if(cap<need) cap=need;
+    c->buf[slot]=OV_REALLOC(s,c->buf[slot],cap);
+    c->cap[slot]=cap;
+  }
+  return c->buf[slot];
+}
+
+/**
+ * Returns the int table 'slot' of 'c' with 'n' entries, all equal to 'v'.
+ * The callers must put back 'v' in the entries they change, so that only
+ * the new entries are filled.
+ * Time: O(1) amortized
+ */
+static int *ctx_table(overlap_ctx_t *c,int slot,int n,int v,overlap_stats_t *s)
+{
+  int i,old=(int)(c->cap[slot]/sizeof(int));
+  int *t=(int*)ctx_buf(c,slot,n,sizeof(int),s);
+  int cap=(int)(c->cap[slot]/sizeof(int));
+  for(i=old;i<cap;i++)
+    t[i]=v;
+  return t;
+}
+
+/**
+ * Renumber the elements used by the sets of 'f' as 0..c->k-1,
+ * in order of first occurence in f->sets, and copy the sets with the local
+ * indices into c->lstart and c->lelms.
+ * Thus the structures of the algorithms have c->k entries instead of
+ * f->grnd_size.
+ * Time: O(\sum_i f->set[i].size)
+ */
+static void ctx_load(overlap_ctx_t *c,const family_t *f)
+{
+  ov_idx_t i,n=0;
+  int j,k=0;
+  int *loc=ctx_table(c,CTX_LOC,f->grnd_size,-1,f->stats);
+  int *glob=(int*)ctx_buf(c,CTX_GLOB,(size_t)f->elms_size,sizeof(int),f->stats);
+  ov_idx_t *lstart=(ov_idx_t*)ctx_buf(c,CTX_LSTART,(size_t)f->size+1,sizeof(ov_idx_t),f->stats);
+  int *lelms=(int*)ctx_buf(c,CTX_LELMS,(size_t)f->elms_size,sizeof(int),f->stats);
+
+  lstart[0]=0;
+  for(i=0;i<f->size;i++) {
+    const int *set=family_set(f,i);
+    for(j=0;j<f->sets.size[i];j++) {
+      int e=set[j];
+      if(loc[e]<0) {
+	loc[e]=k;
+	glob[k++]=e;
+      }
+      lelms[n++]=loc[e];
+    }
+    lstart[i+1]=n;
+  }
+  c->k=k;
+  c->loc=loc;
+  c->glob=glob;
+  c->lstart=lstart;
+  c->lelms=lelms;
+}
+
+/**
+ * Reset the local indices set by ctx_load
+ * Time: O(c->k)
+ */
+static void ctx_unload(overlap_ctx_t *c)
+{
+  int i;
+  for(i=0;i<c->k;i++)
+    c->loc[c->glob[i]]=-1;
+  c->k=0;
+}
+
+/* Counting sort */
+
+#define CSORT_CHUNK 65536 /* minimal number of items of a histogram thread */
+
+/**
+ * Histogram of a part of the items of counting_sort
+ */
+typedef struct {
+  const ov_idx_t *in,*key;
+  ov_idx_t from,to; /* items in[from .. to-1] */
+  ov_idx_t *cnt; /* cnt[k]: number of these items of key k */
+} csort_work_t;
+
+static void *csort_count(void *arg)
+{
+  csort_work_t *w=(csort_work_t*)arg;
+  ov_idx_t j;
+  if(w->in)
+    for(j=w->from;j<w->to;j++)
+      w->cnt[w->key[w->in[j]]]++;
+  else
+    for(j=w->from;j<w->to;j++)
+      w->cnt[w->key[j]]++;
+  return NULL;
+}
+
+/**
+ * Counting sort of the items in[0 .. n-1] (0 .. n-1 if 'in' is NULL) by
+ * their keys key[item], in [0,m]: histogram, prefix sums, and scatter into
+ * 'out'. Items of the same key keep their order, or are put in reverse 
+ * order if 'rev' is set. After the call, the items of key k are 
+ * out[off[k] .. off[k+1]-1] ('off' has m+2 entries).
+ * Two passes give a sort by two keys (least significant first).
+ * The histogram is split between c->nthreads threads if 'n' is large
+ * w.r.t. 'm'. The other tables are taken in 'c'.
+ * Time: O(n+m)
+ */
+static void counting_sort(overlap_ctx_t *c,ov_idx_t n,const ov_idx_t *in,const ov_idx_t *key,ov_idx_t m,ov_idx_t *off,ov_idx_t *out,int rev,overlap_stats_t *s)
+{
+  ov_idx_t j,k,*pos;
+  int i,nt=c->nthreads;
+
+  if(nt>n/CSORT_CHUNK) nt=(int)(n/CSORT_CHUNK);
+  if(nt>1 && m<n/nt) {
+    /* one table of counts by thread, added into 'off' */
+    pthread_t *th=(pthread_t*)malloc(sizeof(pthread_t)*(size_t)nt);
+    csort_work_t *w=(csort_work_t*)malloc(sizeof(csort_work_t)*(size_t)nt);
+    ov_idx_t *cnt=(ov_idx_t*)ctx_buf(c,CTX_CSORT_CNT,(size_t)nt*(size_t)(m+1),sizeof(ov_idx_t),s);
+    for(j=0;j<nt*(m+1);j++)
+      cnt[j]=0;
+    for(i=0;i<nt;i++) {
+      w[i].in=in;
+      w[i].key=key;
+      w[i].from=n/nt*i;
+      w[i].to=i==nt-1?n:n/nt*(i+1);
+      w[i].cnt=cnt+(m+1)*i;
+      if(i>0 && pthread_create(&th[i],NULL,csort_count,&w[i])!=0)
+	w[i].cnt=NULL;
+    }
+    csort_count(&w[0]);
+    for(i=1;i<nt;i++) {
+      if(w[i].cnt==NULL) {
+	w[i].cnt=cnt+(m+1)*i;
+	csort_count(&w[i]);
+      } else
+	pthread_join(th[i],NULL);
+    }
+    off[0]=0;
+    for(k=0;k<=m;k++) {
+      off[k+1]=0;
+      for(i=0;i<nt;i++)
+	off[k+1]+=cnt[(m+1)*i+k];
+    }
+    free(th);
+    free(w);
+  } else {
+    csort_work_t w;
+    for(k=0;k<=m+1;k++)
+      off[k]=0;
+    w.in=in;
+    w.key=key;
+    w.from=0;
+    w.to=n;
+    w.cnt=off+1;
+    csort_count(&w);
+  }
+
+  /* prefix sums, then scatter */
+  pos=(ov_idx_t*)ctx_buf(c,CTX_CSORT_POS,(size_t)m+1,sizeof(ov_idx_t),s);
+  for(k=0;k<=m;k++) {
+    off[k+1]+=off[k];
+    pos[k]=off[k];
+  }
+  if(!rev) {
+    for(j=0;j<n;j++) {
+      ov_idx_t x=in?in[j]:j;
+      out[pos[key[x]]++]=x;
+    }
+  } else {
+    for(j=n-1;j>=0;j--) {
+      ov_idx_t x=in?in[j]:j;
+      out[pos[key[x]]++]=x;
+    }
+  }
+}
+
+/* last stamp given to a family (see family_touch) */
+static unsigned long family_stamps=0;
+
+/**
+ * Give a new stamp to 'f': every change of its sets (creation, addition,
+ * sort, destruction) does it, so a table computed from the sets of 'f' 
+ * (the SL index of sl_get) is known to be valid if 'f' has the same 
+ * stamp, even if another family was created at the same address.
+ * Time: O(1)
+ */
+static void family_touch(family_t *f)
+{
+  f->stamp=__sync_add_and_fetch(&family_stamps,1);
+}
+
 /**
  * Create a empty family
  * Time: O(grnd_size)
@@ -33,29 +394,230 @@
 void family_create(family_t *f,int grnd_size) 
 {
   int i;
+  family_create_ctx(NULL,f,grnd_size);
+
+  /* structure for checking in O(|X|) if X has no multiple elms*/
+  f->grnd_count=(int*)malloc(sizeof(int)*(f->grnd_size>0?f->grnd_size:1));
+  for(i=0;i<f->grnd_size;i++)
+    f->grnd_count[i]=0;
+}
+
+/**
+ * Create a empty family, which uses the table of 'c' to check the sets
+ * (instead of its own grnd_count). 'c' must not be freed before 'f'.
+ * Time: O(1)
+ */
+void family_create_ctx(overlap_ctx_t *c,family_t *f,int grnd_size)
+{
   f->grnd_size=grnd_size;
   f->size=0;
-  f->sets=NULL;
+  f->sets.size=f->sets.left=f->sets.right=f->sets.mleft=f->sets.mright=NULL;
+  f->sets.start=f->sets.max=f->sets.ampos=f->sets.id=NULL;
+  f->sets_cap=0;
+  f->elms=NULL;
+  f->elms_size=0;
+  f->elms_cap=0;
+  f->borrowed=0;
+  f->grnd_count=NULL;
+  f->ctx=c;
+  f->stats=NULL;
+  family_touch(f);
+}
 
-  /* structure for checking in O(|X|) if X has no multiple elms*/
-  f->grnd_count=(int*)malloc(sizeof(int)*f->grnd_size);
+/**
+ * Resize the tables of the sets of 'f' to 'cap' sets.
+ * Returns -1 if memory is exhausted (the tables which could be resized are
+ * kept, f->sets_cap is unchanged).
+ */
+static int family_sets_resize(family_t *f,ov_idx_t cap)
+{
+  family_sets_t *s=&f->sets;
+  size_t n=(size_t)(cap>0?cap:1);
+  void *p;
+#define SETS_RESIZE(t,type) \
+  if((p=realloc(s->t,sizeof(type)*n))==NULL) return -1; \
+  s->t=(type*)p
+  SETS_RESIZE(size,int);
+  SETS_RESIZE(start,ov_idx_t);
+  SETS_RESIZE(left,int);
+  SETS_RESIZE(right,int);
+  SETS_RESIZE(mleft,int);
+  SETS_RESIZE(mright,int);
+  SETS_RESIZE(max,ov_idx_t);
+  SETS_RESIZE(ampos,ov_idx_t);
+  SETS_RESIZE(id,ov_idx_t);
+#undef SETS_RESIZE
+  f->sets_cap=cap;
+  return 0;
+}
+
+/**
+ * Initialize the data of the i-th set of 'f', of 'size' elements from
+ * f->elms[start]
+ */
+static void family_init_set(family_t *f,ov_idx_t i,int size,ov_idx_t start)
+{
+  f->sets.size[i]=size;
+  f->sets.start[i]=start;
+  f->sets.max[i]=-1;
+  f->sets.left[i]=-1;
+  f->sets.right[i]=-1;
+  f->sets.ampos[i]=-1;
+  f->sets.id[i]=i;
+}
+
+/**
+ * The data of the i-th set of 'f', gathered from the tables of f->sets
+ * Time: O(1)
+ */
+set_t family_get_set(const family_t *f,ov_idx_t i)
+{
+  set_t x;
+  x.size=f->sets.size[i];
+  x.start=f->sets.start[i];
+  x.left=f->sets.left[i];
+  x.right=f->sets.right[i];
+  x.mleft=f->sets.mleft[i];
+  x.mright=f->sets.mright[i];
+  x.max=f->sets.max[i];
+  x.ampos=f->sets.ampos[i];
+  x.id=f->sets.id[i];
+  return x;
+}
+
+/**
+ * The table used to check the sets of 'f' (all its entries are 0)
+ */
+static int *family_count(family_t *f)
+{
+  if(f->ctx)
+    return ctx_table(f->ctx,CTX_COUNT,f->grnd_size,0,f->stats);
+  return f->grnd_count;
+}
+
+/**
+ * Create a read-only family over caller-owned tables (no copy): the elements
+ * of the j-th set are elms[offsets[j] .. offsets[j+1]-1]. The tables may be
+ * mmap'd, and must stay valid and unchanged until family_free.
+ * As for family_add_set, sets must be non empty, without multiple elements,
+ * and their elements must be in [0,grnd_size[. This is not checked here
+ * (see family_check_sets_ctx).
+ * Only the per-set data (left, right, max...) is allocated.
+ * Sets cannot be added to a view.
+ * Returns 0, or -1 if memory is exhausted ('f' is then an empty family).
+ * Time: O(nbr)
+ */
+int family_view(family_t *f,int grnd_size,ov_idx_t nbr, const ov_idx_t *offsets, const int *elms)
+{
+  ov_idx_t i;
+  family_create_ctx(NULL,f,grnd_size);
+  if(family_sets_resize(f,nbr)<0) {
+    family_free(f);
+    family_create_ctx(NULL,f,grnd_size);
+    return -1;
+  }
+  f->size=nbr;
+  f->elms=(int*)elms;
+  f->elms_size=offsets[nbr]-offsets[0];
+  f->elms_cap=0;
+  f->borrowed=1;
+
+  for(i=0;i<nbr;i++)
+    family_init_set(f,i,(int)(offsets[i+1]-offsets[i]),offsets[i]);
+  return 0;
+}
+
+/**
+ * Create a family from sets in CSR form (as family_view), where 'elms' was
+ * allocated with malloc by the caller, and offsets[0]==0. 
+ * 'f' takes 'elms' (no copy), and will free it. 'offsets' is not kept.
+ * Sets are checked as in family_add_set.
+ * Returns 0, or -1 if memory is exhausted ('f' is then an empty family, and
+ * 'elms' is not taken).
+ * Time: O(grnd_size + nbr + offsets[nbr])
+ */
+int family_adopt(family_t *f,int grnd_size,ov_idx_t nbr, const ov_idx_t *offsets, int *elms)
+{
+  ov_idx_t j;
+  int i;
+
+  assert(offsets[0]==0);
+  if(family_view(f,grnd_size,nbr,offsets,elms)<0) 
+    return -1;
+  f->grnd_count=(int*)malloc(sizeof(int)*(f->grnd_size>0?f->grnd_size:1));
+  if(f->grnd_count==NULL) {
+    family_free(f);
+    family_create_ctx(NULL,f,grnd_size);
+    return -1;
+  }
+  f->borrowed=0;
+  f->elms_cap=f->elms_size;
   for(i=0;i<f->grnd_size;i++)
     f->grnd_count[i]=0;
+
+  /* check if the sets are correct */
+  for(j=0;j<nbr;j++) {
+    const int *set=family_set(f,j);
+    int size_set=f->sets.size[j];
+    assert(size_set>0 && size_set<=f->grnd_size);
+    for(i=0;i<size_set;i++) {
+      assert(set[i]>=0 && set[i]<f->grnd_size);
+      assert(f->grnd_count[set[i]]==0);
+      f->grnd_count[set[i]]++;
+    }
+    for(i=0;i<size_set;i++)
+      f->grnd_count[set[i]]=0;
+  }
+  return 0;
 }
 
 /** 
- * Destroy a family
- * Time: O(size+grnd_size)
+ * Destroy a family. The tables of a view are not freed.
+ * Time: O(1)
  */
 void family_free(family_t *f)
 {
-  int i;
-  for(i=0;i<f->size;i++) 
-    free(f->sets[i].set);
-  free(f->sets);
+  family_touch(f);
+  free(f->sets.size);
+  free(f->sets.start);
+  free(f->sets.left);
+  free(f->sets.right);
+  free(f->sets.mleft);
+  free(f->sets.mright);
+  free(f->sets.max);
+  free(f->sets.ampos);
+  free(f->sets.id);
+  if(!f->borrowed) free(f->elms);
   free(f->grnd_count);
 }
 
+/**
+ * Ensure that 'f' has room for 'nbr' more sets and 'nelms' more elements.
+ * Tables grow geometrically, so n additions cost O(n) amortized.
+ * Returns -1 (and 'f' is unchanged) if the family would have more than
+ * OV_IDX_MAX sets or elements, or if memory is exhausted.
+ */
+static int family_reserve(family_t *f,ov_idx_t nbr,ov_idx_t nelms)
+{
+  if(nbr>OV_IDX_MAX-f->size || nelms>OV_IDX_MAX-f->elms_size)
+    return -1;
+  if(f->size+nbr>f->sets_cap) {
+    ov_idx_t c=f->sets_cap?f->sets_cap:16;
+    while(c<f->size+nbr) c=c>OV_IDX_MAX/2?OV_IDX_MAX:2*c;
+    if(family_sets_resize(f,c)<0) return -1;
+  }
+  if(f->elms_size+nelms>f->elms_cap) {
+    ov_idx_t c=f->elms_cap?f->elms_cap:64;
+    int *elms;
+    while(c<f->elms_size+nelms) c=c>OV_IDX_MAX/2?OV_IDX_MAX:2*c;
+    elms=(int*)realloc(f->elms,sizeof(int)*(size_t)c);
+    if(elms==NULL) return -1;
+    f->elms=elms;
+    f->elms_cap=c;
+  }
+  return 0;
+}
+
 void print_set(const int *set,int size) 
 {
   int i;
@@ -67,10 +629,12 @@ void print_set(const int *set,int size)
 
 void family_print(const family_t *f)
 {
-  int i,j;
+  ov_idx_t i;
+  int j;
   for(i=0;i<f->size;i++) {
-    for(j=0;j<f->sets[i].size;j++)
-      printf("%d ",f->sets[i].set[j]);
+    const int *set=family_set(f,i);
+    for(j=0;j<f->sets.size[i];j++)
+      printf("%d ",set[j]);
     printf("-1\n");
   }
 }
@@ -80,22 +644,25 @@ void family_print(const family_t *f)
  */
 void family_clear(family_t *f)
 {
-  int i;
+  ov_idx_t i;
   for(i=0;i<f->size;i++) {
-    f->sets[i].max=-1;
-    f->sets[i].left=-1;
-    f->sets[i].right=-1;
-    f->sets[i].ampos=-1;
+    f->sets.max[i]=-1;
+    f->sets.left[i]=-1;
+    f->sets.right[i]=-1;
+    f->sets.ampos[i]=-1;
   }
 }
 
 /**
  * Add a set of 'size' elements int f
- * Time: O(size_set) 
+ * Returns the indice of the set, or -1 if 'f' cannot grow (see family_reserve).
+ * Time: O(size_set) amortized
  */
-int family_add_set(family_t *f, int size_set, const int *set)
+ov_idx_t family_add_set(family_t *f, int size_set, const int *set)
 {
   int i;
+  int *elms;
+  int *count=family_count(f);
 
 #ifdef DEBUG
   printf("add set: ");
@@ -104,82 +671,192 @@ int family_add_set(family_t *f, int size_set, const int *set)
 #endif
 
   /* check if the set is correct */
+  assert(!f->borrowed);
   assert(size_set>0 && size_set<=f->grnd_size);
   for(i=0;i<size_set;i++) {
     assert(set[i]>=0 && set[i]<f->grnd_size);
-    assert(f->grnd_count[set[i]]==0);
-    f->grnd_count[set[i]]++;
+    assert(count[set[i]]==0);
+    count[set[i]]++;
   }
   for(i=0;i<size_set;i++)
-    f->grnd_count[set[i]]=0;
+    count[set[i]]=0;
 
 
   /* add the set to the family */
-  if(f->size==0) f->sets=(set_t*)malloc(sizeof(set_t));
-  else f->sets=(set_t*)realloc(f->sets,sizeof(set_t)*(f->size+1));
-  f->sets[f->size].size=size_set;
-  f->sets[f->size].set=(int*)malloc(size_set*sizeof(int));
-  for(i=0;i<size_set;i++) f->sets[f->size].set[i]=set[i];
-  f->sets[f->size].max=-1;
-  f->sets[f->size].left=-1;
-  f->sets[f->size].right=-1;
-  f->sets[f->size].ampos=-1;
-  f->sets[f->size].id=f->size;
+  if(family_reserve(f,1,size_set)<0) return -1;
+  family_touch(f);
+  elms=f->elms+f->elms_size;
+  for(i=0;i<size_set;i++) elms[i]=set[i];
+  family_init_set(f,f->size,size_set,f->elms_size);
+  f->elms_size+=size_set;
   f->size++;
 
   return f->size-1;
 }
 
+/**
+ * Add 'nbr' sets given in CSR form: the elements of the j-th set are
+ * elms[offsets[j] .. offsets[j+1]-1] ('offsets' has nbr+1 entries).
+ * Returns the indice of the first added set, or -1 if 'f' cannot grow
+ * (then no set is added).
+ * Time: O(nbr + offsets[nbr]-offsets[0]) 
+ */
+ov_idx_t family_add_sets_bulk(family_t *f, ov_idx_t nbr, const ov_idx_t *offsets, const int *elms)
+{
+  ov_idx_t j;
+  int i;
+  ov_idx_t first=f->size;
+  int *count=family_count(f);
+
+  assert(!f->borrowed);
+  if(family_reserve(f,nbr,offsets[nbr]-offsets[0])<0) return -1;
+  family_touch(f);
+  for(j=0;j<nbr;j++) {
+    const int *set=elms+offsets[j];
+    int size_set=(int)(offsets[j+1]-offsets[j]);
+    int *dst=f->elms+f->elms_size;
+
+    assert(size_set>0 && size_set<=f->grnd_size);
+    for(i=0;i<size_set;i++) {
+      assert(set[i]>=0 && set[i]<f->grnd_size);
+      assert(count[set[i]]==0);
+      count[set[i]]++;
+      dst[i]=set[i];
+    }
+    for(i=0;i<size_set;i++)
+      count[set[i]]=0;
+
+    family_init_set(f,f->size,size_set,f->elms_size);
+    f->elms_size+=size_set;
+    f->size++;
+  }
+
+  return first;
+}
+
+/**
+ * Check that the sets of 'f' are as family_add_set requires: non empty,
+ * without multiple elements, and with elements in [0,f->grnd_size[. 
+ * Nothing is asserted, so that a view of unchecked tables (see family_view)
+ * can be rejected. The table of counts is taken in 'c'.
+ * Returns 0, or -1 if a set is not valid.
+ * Time: O(f->size + \sum_i f->sets.size[i]) amortized
+ */
+int family_check_sets_ctx(overlap_ctx_t *c,const family_t *f)
+{
+  int *count=ctx_table(c,CTX_COUNT,f->grnd_size,0,f->stats);
+  ov_idx_t j;
+  int i,k,ok=1;
+
+  for(j=0;j<f->size && ok;j++) {
+    const int *set=family_set(f,j);
+    int size_set=f->sets.size[j];
+    if(size_set<=0 || size_set>f->grnd_size)
+      return -1;
+    for(i=0;i<size_set && ok;i++) {
+      if(set[i]<0 || set[i]>=f->grnd_size || count[set[i]])
+	ok=0;
+      else
+	count[set[i]]=1;
+    }
+    for(k=0;k<i-(ok?0:1);k++)
+      count[set[k]]=0;
+  }
+  return ok?0:-1;
+}
+
 /**
  * Check if sets in 'f' are sorted in decreasing order w.r.t. their size.
  * Time: O(size) 
 */
 int family_check_sort(const family_t *f)
 {
-  int i;
+  ov_idx_t i;
   for(i=1;i<f->size;i++)
-    if(f->sets[i-1].size<f->sets[i].size) return 0;
+    if(f->sets.size[i-1]<f->sets.size[i]) return 0;
   return 1;
 }
 
-/**
- *  Temporary structure to sort a family 
- */
-typedef struct set_srt_s {
-  set_t set;
-  struct set_srt_s *next;
-} set_srt_t ;
 
 /**
- * Sort sets in f in decreasing order w.r.t. their size 
- * Time: O(f->grnd_set + \sum_i f->set[i].size) 
+ * Sort sets in f in decreasing order w.r.t. their size.
+ * Sets of the same size are put in reverse order of insertion.
+ * The permutation is given by a counting sort, then the elements are moved
+ * once in 'f->elms' in the same order, so that the algorithms can walk the
+ * sets linearly. The elements of a view are not moved.
+ * Only size, start, max and id are moved: the other fields of f->sets are
+ * computed by compute_max after the sort.
+ * The table of elements of 'f' is exchanged with the one of 'c'.
+ * Time: O(f->size + \sum_i f->set[i].size)
  */
-void family_sort(family_t *f)
+void family_sort_ctx(overlap_ctx_t *c,family_t *f)
 {
-  set_srt_t **t;
-  int i;
+  ov_idx_t *key,*off,*perm,*tmp;
+  ov_idx_t i,k;
+  int m=0;
   if(family_check_sort(f)) return;
-  
-  t=(set_srt_t**)malloc((f->grnd_size+1)*sizeof(set_srt_t*));
-  for(i=0;i<=f->grnd_size;i++) 
-    t[i]=NULL;
-  for(i=0;i<f->size;i++) {
-    set_srt_t *e=(set_srt_t*)malloc(sizeof(set_srt_t));
-    e->next=t[f->sets[i].size];
-    e->set=f->sets[i];
-    t[f->sets[i].size]=e;
-  }
-  int k=0;
-  for(i=f->grnd_size-1;i>0;i--) {
-    set_srt_t *p=t[i],*pt;
-    while(p) {
-      f->sets[k++]=p->set;
-      pt=p->next;
-      free(p);
-      p=pt;
+  family_touch(f);
+
+  for(i=0;i<f->size;i++)
+    if(f->sets.size[i]>m) m=f->sets.size[i];
+
+  /* decreasing size, reverse order for the same size */
+  key=(ov_idx_t*)ctx_buf(c,CTX_SRT_KEY,(size_t)f->size,sizeof(ov_idx_t),f->stats);
+  off=(ov_idx_t*)ctx_buf(c,CTX_SRT_OFF,(size_t)m+2,sizeof(ov_idx_t),f->stats);
+  perm=(ov_idx_t*)ctx_buf(c,CTX_SRT_PERM,(size_t)f->size,sizeof(ov_idx_t),f->stats);
+  for(i=0;i<f->size;i++)
+    key[i]=m-f->sets.size[i];
+  counting_sort(c,f->size,NULL,key,m,off,perm,1,f->stats);
+
+  /* the elements, then the starts */
+  tmp=(ov_idx_t*)ctx_buf(c,CTX_SETS,(size_t)f->size,sizeof(ov_idx_t),f->stats);
+  if(!f->borrowed) {
+    int *elms=(int*)ctx_buf(c,CTX_ELMS,(size_t)f->elms_cap,sizeof(int),f->stats);
+    ov_idx_t n=0;
+    for(k=0;k<f->size;k++) {
+      ov_idx_t j=perm[k];
+      const int *set=family_set(f,j);
+      int l;
+      tmp[k]=n;
+      for(l=0;l<f->sets.size[j];l++)
+	elms[n++]=set[l];
     }
-  }
-  free(t);
+
+    /* exchange the tables */
+    c->buf[CTX_ELMS]=f->elms;
+    f->elms=elms;
+    i=(ov_idx_t)(c->cap[CTX_ELMS]/sizeof(int));
+    c->cap[CTX_ELMS]=(size_t)f->elms_cap*sizeof(int);
+    f->elms_cap=i;
+    f->elms_size=n;
+  } else
+    for(k=0;k<f->size;k++)
+      tmp[k]=f->sets.start[perm[k]];
+  for(k=0;k<f->size;k++)
+    f->sets.start[k]=tmp[k];
+
+  /* the other fields (left, right... are computed after the sort) */
+  for(k=0;k<f->size;k++)
+    tmp[k]=f->sets.size[perm[k]];
+  for(k=0;k<f->size;k++)
+    f->sets.size[k]=(int)tmp[k];
+  for(k=0;k<f->size;k++)
+    tmp[k]=f->sets.max[perm[k]];
+  for(k=0;k<f->size;k++)
+    f->sets.max[k]=tmp[k];
+  for(k=0;k<f->size;k++)
+    tmp[k]=f->sets.id[perm[k]];
+  for(k=0;k<f->size;k++)
+    f->sets.id[k]=tmp[k];
+}
+
+void family_sort(family_t *f)
+{
+  overlap_ctx_t *c;
+  if(family_check_sort(f)) return;
+  c=overlap_ctx_create();
+  family_sort_ctx(c,f);
+  overlap_ctx_free(c);
 }
 
 
@@ -211,20 +888,27 @@ typedef struct {
  *  Each element in 't' has a reference to his class.
  * - on table 'ind' indiced by the elements of the ground set. 
  *  ind[i] is the indice of the element 'i' in 't'
+ * There are at most 'size' classes, they are taken in 'classes'.
  */
 typedef struct {
   int size; /* size of the ground set */
   ref_elm_t *t; 
   int *ind;
+  ref_class_t *classes;
+  int nclasses;
+  ref_class_t **hit; /* classes hit by the current set */
+  overlap_stats_t *stats;
 } ref_t;
 
 /** 
  * Create a new class in the refine structure.
  * Time: O(1)
  */
-static ref_class_t *new_ref_class_t(int start_,int end_) 
+static ref_class_t *new_ref_class_t(ref_t *r,int start_,int end_) 
 {
-  ref_class_t *c=(ref_class_t*)malloc(sizeof(ref_class_t));
+  ref_class_t *c=r->classes+r->nclasses++;
+  assert(r->nclasses<=r->size);
+  STAT_ADD(r->stats,classes,1);
   c->start=start_;
   c->end=end_;
   c->mark=0;
@@ -232,43 +916,30 @@ static ref_class_t *new_ref_class_t(int start_,int end_)
 }
 
 /**
- * Create the refine strucutre, with one class
+ * Create the refine strucutre, with one class, in the tables of 'c'
  * Time: O(size)
  */
-static void ref_init(ref_t *r,int s)
+static void ref_init(ref_t *r,overlap_ctx_t *c,int s,overlap_stats_t *stats)
 {
   int i;
-  ref_class_t *c;
+  ref_class_t *cl;
   r->size=s;
+  r->stats=stats;
   assert(s>0);
-  r->t=(ref_elm_t*)malloc(sizeof(ref_elm_t)*s);
-  c=new_ref_class_t(0,s-1);
-  r->ind=(int*)malloc(sizeof(int)*s);
+  r->t=(ref_elm_t*)ctx_buf(c,CTX_REF_T,s,sizeof(ref_elm_t),stats);
+  r->ind=(int*)ctx_buf(c,CTX_REF_IND,s,sizeof(int),stats);
+  r->classes=(ref_class_t*)ctx_buf(c,CTX_CLASSES,s,sizeof(ref_class_t),stats);
+  r->hit=(ref_class_t**)ctx_buf(c,CTX_HIT,s,sizeof(ref_class_t*),stats);
+  r->nclasses=0;
+  cl=new_ref_class_t(r,0,s-1);
   for(i=0;i<r->size;i++) {
     r->t[i].member=i;
-    r->t[i].clas=c;
+    r->t[i].clas=cl;
     r->t[i].mark=0;
     r->ind[i]=i;
   }
 }
 
-/** 
- * Delete the refine structure
- * Time: O(size) 
- */
-static void ref_free(ref_t *r) 
-{
-  ref_class_t *o=NULL;
-  int i;
-  for(i=0;i<r->size;i++) {
-    if(r->t[i].clas!=o) 
-      free(r->t[i].clas);
-    o=r->t[i].clas;
-  }
-  free(r->t);
-  free(r->ind);
-}
-
 static void ref_print(const ref_t *r,int check)
 {
   int i,j;
@@ -303,6 +974,7 @@ static void ref_print(const ref_t *r,int check)
 static void xcg(ref_t *r, int a,int b)  
 {
   if(a==b) return;
+  STAT_ADD(r->stats,xcg,1);
   ref_elm_t tmp=r->t[b];
 
   int tmp2=r->ind[r->t[b].member];
@@ -323,9 +995,11 @@ static void refine(ref_t *r,const int *X, int size_X, void (*fct)(void *,const r
   int i,j;
 
   /* classes hit by X */
-  ref_class_t **clas=(ref_class_t**)malloc(sizeof(ref_class_t*)*size_X); 
+  ref_class_t **clas=r->hit;
   int nbrclass=0;
 
+  STAT_ADD(r->stats,refine,1);
+
 #ifdef DEBUG
   printf("refine by: ");print_set(X,size_X);
 #endif
@@ -363,7 +1037,7 @@ static void refine(ref_t *r,const int *X, int size_X, void (*fct)(void *,const r
     
     if(c->mark<1+c->end-c->start) {
       /*printf("(mark=%d) class %d,%d -> ",c->mark,c->start,c->end);*/
-      ref_class_t *c2=new_ref_class_t(c->end-c->mark+1,c->end);
+      ref_class_t *c2=new_ref_class_t(r,c->end-c->mark+1,c->end);
       
       if(fct) fct(data,c,c->start,c->end-c->mark,c->end);
       
@@ -419,7 +1093,7 @@ static void leftright(const ref_t *r,const int *X, int size_X,int *left,int *rig
  * - a boolean saying if the set is removed
  */
 typedef struct {
-  int set;
+  ov_idx_t set;
   int ok;
 } am_elm_t;
 
@@ -430,110 +1104,57 @@ typedef struct {
  */
 typedef struct {
   am_elm_t *t;
-  int *ti;
+  ov_idx_t *ti;
 } am_t;
 
 /**
- * Temporary structure to sort the AM structure
+ * Create a AM_structure in the tables of 'c', by two counting sorts.
+ * 'left' and 'right' are in [0,c->k[.
+ * Time: O(c->k + f->size)
  */
-typedef struct am_srt_s {
-  int set;
-  struct am_srt_s *next;
-} am_srt_t;
-
-/**
- * Create a AM_structure
- * Time: O(f->grnd_size + f->size)
- */
-static void am_create(am_t *am, const family_t *f) 
+static void am_create(am_t *am,overlap_ctx_t *c,family_t *f)
 {
-  int i,j,k;  
-  
-  /* temporary table for sorting in O(f->grnd_size) */
-  am_srt_t **tt=(am_srt_t**)malloc(sizeof(am_srt_t*)*f->grnd_size); 
-  int *ti;
-
-  am->t=(am_elm_t*)malloc(sizeof(am_elm_t)*f->size);
-  am->ti=(int*)malloc(sizeof(int)*f->grnd_size);
-
-  /* Number of set with right==i */
-  ti=(int*)malloc(sizeof(int)*f->grnd_size); 
-  
-  for(i=0;i<f->grnd_size;i++) {
-    tt[i]=NULL;
-    am->ti[i]=0;
-    ti[i]=0;
-  }
-  
-  for(i=0;i<f->size;i++) { /*Sort by 'left'. O(f->size) */
-    am_srt_t *e=(am_srt_t*)malloc(sizeof(am_srt_t));
-    e->next=tt[f->sets[i].left];
-    e->set=i;
-    tt[f->sets[i].left]=e;
-    am->ti[f->sets[i].right]++;
-  }
+  ov_idx_t i;
+  int n=c->k;
+  ov_idx_t *key=(ov_idx_t*)ctx_buf(c,CTX_AM_KEY,(size_t)f->size,sizeof(ov_idx_t),f->stats);
+  ov_idx_t *off=(ov_idx_t*)ctx_buf(c,CTX_AM_OFF,(size_t)n+1,sizeof(ov_idx_t),f->stats);
+  ov_idx_t *perm=(ov_idx_t*)ctx_buf(c,CTX_AM_PERM,(size_t)f->size,sizeof(ov_idx_t),f->stats);
+  ov_idx_t *srt=(ov_idx_t*)ctx_buf(c,CTX_AM_SRT,(size_t)f->size,sizeof(ov_idx_t),f->stats);
+
+  am->t=(am_elm_t*)ctx_buf(c,CTX_AM_T,(size_t)f->size,sizeof(am_elm_t),f->stats);
+  am->ti=(ov_idx_t*)ctx_buf(c,CTX_AM_TI,(size_t)n+1,sizeof(ov_idx_t),f->stats);
+
+  /* sort by 'left' (reverse order for the same left), then by 'right':
+     am->ti[i] is the first set with right=i */
+  for(i=0;i<f->size;i++)
+    key[i]=f->sets.left[i];
+  counting_sort(c,f->size,NULL,key,n-1,off,perm,1,f->stats);
+  for(i=0;i<f->size;i++)
+    key[i]=f->sets.right[i];
+  counting_sort(c,f->size,perm,key,n-1,am->ti,srt,0,f->stats);
 
-  j=0;
   for(i=0;i<f->size;i++) {
-    am->t[i].set=-1;
-  }
-
-  for(i=0;i<f->grnd_size;i++) { /* Computes am->ti */
-    k=j+am->ti[i];
-    am->ti[i]=j;
-    j=k;
-  }
-  
-  for(i=0;i<f->grnd_size;i++) { /* Sort by right, and put into am->t
-				   O(f->size+f->grnd_size) */
-    am_srt_t *p=tt[i],*pt;
-    while(p) {
-      int right=f->sets[p->set].right;
-      int pos=am->ti[right]+ti[right];
 #ifdef DEBUG
-      printf("am1: %d %d\n",f->sets[p->set].left,f->sets[p->set].right);
+    printf("am1: %d %d\n",f->sets.left[srt[i]],f->sets.right[srt[i]]);
 #endif
-      am->t[pos].set=p->set;
-      am->t[pos].ok=1;
-      f->sets[p->set].ampos=pos;
-      ti[right]++;
-      pt=p;
-      p=p->next;
-      free(pt);
-    }
+    am->t[i].set=srt[i];
+    am->t[i].ok=1;
+    f->sets.ampos[srt[i]]=i;
   }
 
 #ifdef DEBUG
   for(i=0;i<f->size;i++) { 
     if(am->t[i].set==-1)
-      printf("am2 %d: NULL\n",i);
+      printf("am2 %lld: NULL\n",(long long)i);
     else 
-      printf("am2 %d: %d %d\n",i,f->sets[am->t[i].set].left,f->sets[am->t[i].set].right);
+      printf("am2 %lld: %d %d\n",(long long)i,f->sets.left[am->t[i].set],f->sets.right[am->t[i].set]);
   }
 
-  for(i=0;i<f->grnd_size;i++) {
-    printf("am3 %d: %d\n",i,am->ti[i]);
+  for(i=0;i<n;i++) {
+    printf("am3 %lld: %lld\n",(long long)i,(long long)am->ti[i]);
   }
 #endif
 
-  free(tt);
-  for(i=0;i<f->grnd_size;i++) {
-#ifdef DEBUG
-    printf("amc %d: %d\n",i,ti[i]);
-#endif
-    assert(ti[i]==(i+1==f->grnd_size?f->size:am->ti[i+1])-am->ti[i]);
-  }
-  free(ti);
-}
-
-/**
- * Destroy a AM_structure
- * Time: O(f->grnd_size + f->size)
- */
-static void am_free(am_t *am)
-{
-  free(am->t);
-  free(am->ti);
 } 
 
 /**
@@ -542,7 +1163,7 @@ static void am_free(am_t *am)
 typedef struct {
   am_t *am;
   family_t *f;
-  int set;
+  ov_idx_t set;
 } fct_data_t;
 
 /**
@@ -554,161 +1175,185 @@ static void fct_test(void *data,const ref_class_t *c, int start, int end, int en
   fct_data_t *d=(fct_data_t*)data;
   am_t *am=d->am;
   family_t *f=d->f;
+  const int *left=f->sets.left,*right=f->sets.right;
   int i;
   
+  STAT_ADD(f->stats,fct_test,1);
   for(i=end+1;i<=end2;i++) {
     while(1) {
       if(am->ti[i]==f->size) 
 	break; /*end of the AM structure */
       
-      int set=am->t[am->ti[i]].set; 
-      if(f->sets[set].right!=i) 
+      ov_idx_t set=am->t[am->ti[i]].set; 
+      if(right[set]!=i) 
 	break; /*there is no more sets with right=i*/
-      if(am->t[am->ti[i]].ok==0) 
+      if(am->t[am->ti[i]].ok==0) {
 	/* if ok==0, the set is already removed form the structure */
 	am->ti[i]++;
-      else if(f->sets[set].left<=end) {
+	STAT_ADD(f->stats,am_advance,1);
+      } else if(left[set]<=end) {
 	/*otherwise, this is the first time that left(X) and right(X) are 
 	  separated by a set Y. Thus Max(X)=Y */
-	f->sets[set].max=d->set;
+	f->sets.max[set]=d->set;
 	am->ti[i]++;
+	STAT_ADD(f->stats,am_advance,1);
       } else break;
     }
   }
 }
 
 /**
- * Compute Maxs.
- * Time: O(f->grnd_size + \sum_i f->sets[i].size)
+ * Compute Maxs, using the tables of 'c'.
+ * The refine and AM structures only have an entry for the elements used by
+ * the sets (see ctx_load): 'left' and 'right' are positions among them,
+ * 'mleft' and 'mright' are elements of the ground set.
+ * Time: O(f->size + \sum_i f->sets.size[i])
  */
-void compute_max(family_t *f)
+void compute_max_ctx(overlap_ctx_t *c,family_t *f)
 {
-  int i;
-  ref_t *r;
-  am_t *am;
-  int op;
+  ov_idx_t i;
+  ref_t r;
+  am_t am;
+  fct_data_t data;
+  ov_idx_t op;
+  double t=f->stats?overlap_time():0;
   
-  family_sort(f);
+  STAT_PHASE(f->stats,PH_SORT);
+  family_sort_ctx(c,f);
+  stats_phase(f->stats,PH_SORT,&t);
+  if(f->size==0) return;
 
   /* 1st refining */ 
 
-  r=(ref_t*)malloc(sizeof(ref_t));
-  ref_init(r,f->grnd_size);
+  STAT_PHASE(f->stats,PH_REFINE1);
+  ctx_load(c,f);
+  ref_init(&r,c,c->k,f->stats);
   for(i=0;i<f->size;i++)
-    refine(r,f->sets[i].set,f->sets[i].size,NULL,NULL);
+    refine(&r,ctx_set(c,i),f->sets.size[i],NULL,NULL);
+  stats_phase(f->stats,PH_REFINE1,&t);
 
 
   /* comute left and right for all sets */
+  STAT_PHASE(f->stats,PH_LEFTRIGHT);
 
   for(i=0;i<f->size;i++) {
-    leftright(r,f->sets[i].set,f->sets[i].size,
-	      &(f->sets[i].left),&(f->sets[i].right),
-	      &(f->sets[i].mleft),&(f->sets[i].mright)
+    leftright(&r,ctx_set(c,i),f->sets.size[i],
+	      &(f->sets.left[i]),&(f->sets.right[i]),
+	      &(f->sets.mleft[i]),&(f->sets.mright[i])
 	      );
+    f->sets.mleft[i]=c->glob[f->sets.mleft[i]];
+    f->sets.mright[i]=c->glob[f->sets.mright[i]];
 #ifdef DEBUG
-    printf("%d: left=%d right=%d\n",i,(f->sets[i].left),(f->sets[i].right));
+    printf("%lld: left=%d right=%d\n",(long long)i,(f->sets.left[i]),(f->sets.right[i]));
 #endif
   }
-  ref_free(r);
+  stats_phase(f->stats,PH_LEFTRIGHT,&t);
   
-  am=(am_t*)malloc(sizeof(am_t));
-  am_create(am,f);
+  STAT_PHASE(f->stats,PH_AM);
+  am_create(&am,c,f);
+  stats_phase(f->stats,PH_AM,&t);
   
   /* 2nd refining */ 
 
-  ref_init(r,f->grnd_size);  
+  STAT_PHASE(f->stats,PH_REFINE2);
+  ref_init(&r,c,c->k,f->stats);
+  data.am=&am;
+  data.f=f;
   op=0;
   for(i=0;i<f->size;i++) {
-    fct_data_t *data=(fct_data_t*)malloc(sizeof(fct_data_t)); 
-    data->am=am;
-    data->set=i;
-    data->f=f;
-    refine(r,f->sets[i].set,f->sets[i].size,fct_test,data);
-    free(data);
-
-    if(i==f->size-1 || f->sets[i+1].size!=f->sets[i].size) {
+    data.set=i;
+    refine(&r,ctx_set(c,i),f->sets.size[i],fct_test,&data);
+
+    if(i==f->size-1 || f->sets.size[i+1]!=f->sets.size[i]) {
       /* there is no more X' with |X'|=|X|:
          remove from AM all X' with |X'|=|X| */    
       for(;op<=i;op++)
-	am->t[f->sets[op].ampos].ok=0;
+	am.t[f->sets.ampos[op]].ok=0;
     }
   }
-  
-  ref_free(r);
-  free(r);
-  am_free(am);
-  free(am);
+  ctx_unload(c);
+  stats_phase(f->stats,PH_REFINE2,&t);
 
 #ifdef DEBUG
   for(i=0;i<f->size;i++) {
-    printf("set: ");print_set(f->sets[i].set,f->sets[i].size);
-    printf(" max=%d\n",f->sets[i].max);
-    if(f->sets[i].max>=0) {
-      printf(" max: ");print_set(f->sets[f->sets[i].max].set,f->sets[f->sets[i].max].size);
+    printf("set: ");print_set(family_set(f,i),f->sets.size[i]);
+    printf(" max=%lld\n",(long long)f->sets.max[i]);
+    if(f->sets.max[i]>=0) {
+      printf(" max: ");print_set(family_set(f,f->sets.max[i]),f->sets.size[f->sets.max[i]]);
     }
   }
 #endif
 }
 
-/* SL structure */
-
 /**
- * Element of a SL structure 
+ * Compute Maxs.
+ * Time: O(f->grnd_size + \sum_i f->sets.size[i])
  */
-typedef struct sl_elm_s {
-  int set;
-  struct sl_elm_s *next;
-} sl_elm_t;
+void compute_max(family_t *f)
+{
+  overlap_ctx_t *c=overlap_ctx_create();
+  compute_max_ctx(c,f);
+  overlap_ctx_free(c);
+}
+
+/* SL structure */
 
 /**
- * SL structure (table of lists)
+ * SL index: for each element of the ground set (local indices of 'c', see
+ * ctx_load), the sets containing it in <_LF order, in CSR form: the sets
+ * of the element k are set[off[k] .. off[k+1]-1].
  */
 typedef struct {
   int size;
-  sl_elm_t **t;
+  ov_idx_t *off; /* size+1 entries */
+  ov_idx_t *set;
 } sl_t;
 
 /**
- * Create a SL structure
- * Each list is sorted in <_LF order
- * Time: O(f->grnd_size + \sum_i f->sets[i].size)
+ * Returns 1 if 'c' keeps the SL index of 'f' (see sl_get)
  */
-static void sl_create(sl_t *s,const family_t *f)
+static int sl_kept(const overlap_ctx_t *c,const family_t *f)
 {
-  int i,j;
-  s->t=(sl_elm_t**)malloc(sizeof(sl_elm_t*)*f->grnd_size);
-  s->size=f->grnd_size;
-  for(i=0;i<f->grnd_size;i++) {
-    s->t[i]=NULL;
-  }
-  for(i=0;i<f->size;i++) {
-    for(j=0;j<f->sets[i].size;j++) {
-      int k=f->sets[i].set[j];
-      sl_elm_t *e=(sl_elm_t*)malloc(sizeof(sl_elm_t));
-      e->next=s->t[k];
-      e->set=i;
-      s->t[k]=e;
-    }
-  }
+  return c->sl_f==f && c->sl_stamp==f->stamp;
 }
 
 /**
- * Destroy SL structure
- * Time: O(f->grnd_size + \sum_i f->sets[i].size)
+ * Get the SL index of 'f' on the local indices of 'c' (ctx_load must have
+ * been called). It is built by two counting passes over the sets, and 
+ * kept in 'c' with the Maxs: the next builders on 'f' reuse it, as long
+ * as the sets of 'f' do not change (see family_touch). Both graph 
+ * builders go through it; the union-find engine reads it only if it is 
+ * kept, since its single sweep over the sets is faster than a build.
+ * Time: O(c->k + \sum_i f->sets.size[i]), O(1) if it is kept
  */
-static void sl_free(sl_t *s)
+static void sl_get(sl_t *s,overlap_ctx_t *c,const family_t *f)
 {
-
-  int j;
-  for(j=0;j<s->size;j++) {
-    sl_elm_t *p=s->t[j],*pt;
-    while(p) {
-      pt=p->next;
-      free(p);
-      p=pt;
-    }
-  }
-  free(s->t);
+  ov_idx_t i,j;
+  int k;
+  s->size=c->k;
+  s->off=(ov_idx_t*)ctx_buf(c,CTX_SL_OFF,(size_t)c->k+1,sizeof(ov_idx_t),f->stats);
+  s->set=(ov_idx_t*)ctx_buf(c,CTX_SL_SET,(size_t)c->lstart[f->size],sizeof(ov_idx_t),f->stats);
+  if(sl_kept(c,f))
+    return;
+
+  /* off[k+1]: number of sets containing k */
+  for(k=0;k<=s->size;k++)
+    s->off[k]=0;
+  for(j=0;j<c->lstart[f->size];j++)
+    s->off[c->lelms[j]+1]++;
+  for(k=0;k<s->size;k++)
+    s->off[k+1]+=s->off[k];
+
+  /* off[k] moves to the end of the sets of k, i.e. off[k+1] */
+  for(i=f->size-1;i>=0;i--)
+    for(j=c->lstart[i];j<c->lstart[i+1];j++)
+      s->set[s->off[c->lelms[j]]++]=i;
+  for(k=s->size;k>0;k--)
+    s->off[k]=s->off[k-1];
+  s->off[0]=0;
+
+  c->sl_f=f;
+  c->sl_stamp=f->stamp;
 }
 
 
@@ -716,134 +1361,298 @@ static void sl_free(sl_t *s)
  * Create a empty graph of 'n' vertices
  * Time: O(n)
  */
-void graph_create(graph_t *g, int n)
+void graph_create(graph_t *g, ov_idx_t n)
 {
-  int i;
+  ov_idx_t i;
   g->n=n;
-  g->t=(edge_t**)malloc(sizeof(edge_t*)*g->n);
-  for(i=0;i<g->n;i++)
-    g->t[i]=NULL;
+  g->stats=NULL;
+  g->off=(ov_idx_t*)malloc(sizeof(ov_idx_t)*(size_t)(g->n+1));
+  for(i=0;i<=g->n;i++)
+    g->off[i]=0;
+  g->adj=NULL;
+  g->edges=NULL;
+  g->nedges=0;
+  g->edges_cap=0;
 }
 
 void graph_free(graph_t *g)
 {
-  int i;
-  for(i=0;i<g->n;i++) {
-    edge_t *e=g->t[i],*et;
-    while(e) {
-      et=e->next;
-      free(e);
-      e=et;
-    }
-  }
-  free(g->t);
-}
-
-static void graph_add_half_edge(graph_t *g,int i,int j)
-{
-  edge_t *e=(edge_t*)malloc(sizeof(edge_t));
-  e->v=i;
-  e->next=g->t[j];
-  g->t[j]=e;
+  free(g->off);
+  free(g->adj);
+  free(g->edges);
 }
 
 /**
  * Add an edge in g
- * Time: constant
+ * Time: constant (amortized)
  */
-void graph_add_edge(graph_t *g,int i,int j)
+void graph_add_edge(graph_t *g,ov_idx_t i,ov_idx_t j)
 {
   assert(i!=j && i>=0 && j>=0 && i<g->n && j<g->n);
-  graph_add_half_edge(g,i,j);
-  graph_add_half_edge(g,j,i);
+  if(g->nedges==g->edges_cap) {
+    g->edges_cap=g->edges_cap?2*g->edges_cap:1024;
+    g->edges=(ov_idx_t*)OV_REALLOC(g->stats,g->edges,sizeof(ov_idx_t)*2*(size_t)g->edges_cap);
+  }
+  STAT_ADD(g->stats,edges,1);
+  g->edges[2*g->nedges]=i;
+  g->edges[2*g->nedges+1]=j;
+  g->nedges++;
 }
 
 /** 
- * Sort adjacency lists of 'g' and remove multiple edges.
- * Time: linear in the size of g
+ * Give the edge buffer of 'c' to 'g' (it is taken back by graph_sort_ctx)
  */
-void graph_sort(graph_t *g)
+static void graph_lend_edges(overlap_ctx_t *c,graph_t *g)
 {
-  graph_t g2;
-  int i;
+  assert(g->edges==NULL);
+  g->edges=(ov_idx_t*)c->buf[CTX_EDGES];
+  g->edges_cap=(ov_idx_t)(c->cap[CTX_EDGES]/(2*sizeof(ov_idx_t)));
+  c->buf[CTX_EDGES]=NULL;
+  c->cap[CTX_EDGES]=0;
+}
 
-  graph_create(&g2,g->n);
-  for(i=g->n-1;i>=0;i--) {
-    edge_t *e=g->t[i];
-    while(e) {
-      if(g2.t[e->v]==NULL || g2.t[e->v]->v!=i)
-	graph_add_half_edge(&g2,i,e->v);
-      e=e->next;
+/**
+ * Put the edges added by graph_add_edge into the CSR tables, 
+ * sort adjacency lists of 'g' and remove multiple edges.
+ * Two counting sorts: half-edges u->v are first bucketed by v, then 
+ * scattered by u, taking v in increasing order. Thus every list is sorted
+ * and a multiple edge is next to its copy.
+ * The temporary tables are taken in 'c', and the edge buffer of 'g' is
+ * kept by 'c' for the next graph. Only g->adj is allocated.
+ * Time: linear in the size of g
+ */
+void graph_sort_ctx(overlap_ctx_t *c,graph_t *g)
+{
+  ov_idx_t n=g->n;
+  ov_idx_t m=g->off[n]+2*g->nedges; /* number of half-edges */
+  ov_idx_t *cnt=(ov_idx_t*)ctx_buf(c,CTX_CNT,(size_t)n+1,sizeof(ov_idx_t),g->stats); /* buckets by v */
+  ov_idx_t *beg=(ov_idx_t*)ctx_buf(c,CTX_BEG,(size_t)n+1,sizeof(ov_idx_t),g->stats); /* start of the list of u */
+  ov_idx_t *pos=(ov_idx_t*)ctx_buf(c,CTX_POS,(size_t)n+1,sizeof(ov_idx_t),g->stats); /* end of the list of u */
+  ov_idx_t *src=(ov_idx_t*)ctx_buf(c,CTX_SRC,(size_t)m,sizeof(ov_idx_t),g->stats); /* half-edges sorted by v */
+  ov_idx_t *adj=(ov_idx_t*)OV_MALLOC(g->stats,sizeof(ov_idx_t)*(size_t)(m>0?m:1));
+  ov_idx_t i,j,k;
+
+  for(i=0;i<=n;i++)
+    cnt[i]=beg[i]=0;
+
+  /* 1st pass: count, then bucket half-edges u->v by v */
+  for(i=0;i<n;i++)
+    for(j=g->off[i];j<g->off[i+1];j++) {
+      cnt[g->adj[j]]++;
+      beg[i]++;
     }
+  for(k=0;k<2*g->nedges;k+=2) {
+    cnt[g->edges[k]]++;
+    cnt[g->edges[k+1]]++;
+    beg[g->edges[k]]++;
+    beg[g->edges[k+1]]++;
+  }
+  for(i=0,j=0,k=0;i<n;i++) {
+    ov_idx_t c=cnt[i],d=beg[i];
+    cnt[i]=j;
+    beg[i]=pos[i]=k;
+    j+=c;
+    k+=d;
   }
+  for(i=0;i<n;i++)
+    for(j=g->off[i];j<g->off[i+1];j++) 
+      src[cnt[g->adj[j]]++]=i;
+  for(k=0;k<2*g->nedges;k+=2) {
+    src[cnt[g->edges[k+1]]++]=g->edges[k];
+    src[cnt[g->edges[k]]++]=g->edges[k+1];
+  }
+  /* now cnt[v] is the end of the bucket of v */
+
+  /* 2nd pass: scatter by u, v in increasing order; skip multiple edges */
+  for(i=0,j=0;i<n;i++) 
+    for(;j<cnt[i];j++) {
+      ov_idx_t u=src[j];
+      if(pos[u]==beg[u] || adj[pos[u]-1]!=i)
+	adj[pos[u]++]=i;
+    }
 
-  graph_free(g);
-  *g=g2;
+  /* remove the holes left by multiple edges */
+  for(i=0,k=0;i<n;i++) {
+    g->off[i]=k;
+    for(j=beg[i];j<pos[i];j++)
+      adj[k++]=adj[j];
+  }
+  g->off[n]=k;
+  STAT_ADD(g->stats,edges_sorted,k/2);
+  free(g->adj);
+  g->adj=adj;
+
+  /* the edge buffer goes to 'c' */
+  free(c->buf[CTX_EDGES]);
+  c->buf[CTX_EDGES]=g->edges;
+  c->cap[CTX_EDGES]=g->edges?2*sizeof(ov_idx_t)*(size_t)g->edges_cap:0;
+  g->edges=NULL;
+  g->nedges=0;
+  g->edges_cap=0;
+}
+
+void graph_sort(graph_t *g)
+{
+  overlap_ctx_t *c=overlap_ctx_create();
+  graph_sort_ctx(c,g);
+  overlap_ctx_free(c);
 }
 
 void graph_print(const graph_t *g)
 {
-  int i;
+  ov_idx_t i,j;
   for(i=0;i<g->n;i++) {
-    edge_t *e=g->t[i];
-    printf("%d:",i);
-    while(e) {
-      printf(" %d",e->v);
-      e=e->next;
-    }
+    printf("%lld:",(long long)i);
+    for(j=g->off[i];j<g->off[i+1];j++)
+      printf(" %lld",(long long)g->adj[j]);
     printf("\n");
   }
 }
 
-/** 
- * Computes the Dahlhaus graph 
- * Time: O(f->grnd_size + \sum_i f->set[i].size)
+/**
+ * Function called on every edge generated by the graph builders
  */
-void graph_dahlhaus_create(graph_t *g,const family_t *f)
+typedef void (*edge_fct_t)(void *data,ov_idx_t i,ov_idx_t j);
+
+static void edge_to_graph(void *data,ov_idx_t i,ov_idx_t j)
 {
-  int i;
-  sl_t sl;
+  graph_add_edge((graph_t*)data,i,j);
+}
 
-  graph_create(g,f->size);
-  sl_create(&sl,f);
+static void edge_to_uf(void *data,ov_idx_t i,ov_idx_t j)
+{
+  uf_union((uf_t*)data,i,j);
+}
 
-  for(i=0;i<sl.size;i++) {
-    sl_elm_t *e=sl.t[i];
+/**
+ * Generates the edges of the Dahlhaus graph from the SL index of 'f',
+ * built if 'c' does not keep it (see sl_get).
+ * A set of SL(k) is joined to the previous one if it is not larger than
+ * the largest Max of the sets before it in SL(k).
+ * Time: O(f->size + \sum_i f->set[i].size)
+ */
+static void dahlhaus_edges_sl(overlap_ctx_t *c,const family_t *f,edge_fct_t fct,void *data)
+{
+  sl_t sl;
+  int k;
+  const int *size=f->sets.size; /* the only fields read */
+  const ov_idx_t *max=f->sets.max;
+
+  if(f->size==0) return;
+  ctx_load(c,f);
+  sl_get(&sl,c,f);
+  for(k=0;k<sl.size;k++) {
+    ov_idx_t e,prev=-1;
     int smax=-1;
-    while(e) {
-      int set=e->set;
-      if(f->sets[set].max>=0 && f->sets[f->sets[set].max].size>smax)
-	smax=f->sets[f->sets[set].max].size;
-      if(e->next!=NULL) {
-	int set2=e->next->set;
-	if(f->sets[set2].size<=smax)
-	  graph_add_edge(g,set,set2);
-      }
-      e=e->next;
+    for(e=sl.off[k];e<sl.off[k+1];e++) {
+      ov_idx_t i=sl.set[e];
+      if(prev>=0 && size[i]<=smax)
+	fct(data,prev,i);
+      if(max[i]>=0 && size[max[i]]>smax)
+	smax=size[max[i]];
+      prev=i;
     }
   }
+  ctx_unload(c);
+}
 
-  graph_sort(g);
+/**
+ * Generates the edges of the Dahlhaus graph.
+ * SL(k) is the list of the sets containing 'k' in <_LF order, i.e. by 
+ * decreasing indice. If 'c' keeps the SL index of 'f', it is read 
+ * (dahlhaus_edges_sl). Otherwise the index is not built: the sets are 
+ * read by decreasing indice, and for every element 'k' we only keep the 
+ * previous set of SL(k) and the size of the largest Max seen in SL(k).
+ * Time: O(f->size + \sum_i f->set[i].size)
+ * Memory: O(c->k)
+ */
+static void dahlhaus_edges(overlap_ctx_t *c,const family_t *f,edge_fct_t fct,void *data)
+{
+  ov_idx_t i;
+  int j;
+  ov_idx_t *prev;
+  int *smax;
+  const int *size=f->sets.size; /* the only fields read */
+  const ov_idx_t *max=f->sets.max;
+
+  if(f->size==0) return;
+  if(sl_kept(c,f)) {
+    dahlhaus_edges_sl(c,f,fct,data);
+    return;
+  }
+  ctx_load(c,f);
+  prev=(ov_idx_t*)ctx_buf(c,CTX_PREV,(size_t)c->k,sizeof(ov_idx_t),f->stats);
+  smax=(int*)ctx_buf(c,CTX_SMAX,(size_t)c->k,sizeof(int),f->stats);
+  for(j=0;j<c->k;j++) {
+    prev[j]=-1;
+    smax[j]=-1;
+  }
 
-  sl_free(&sl);
+  for(i=f->size-1;i>=0;i--) {
+    const int *set=ctx_set(c,i);
+    int si=size[i];
+    int sm=max[i]>=0?size[max[i]]:-1;
+    for(j=0;j<si;j++) {
+      int k=set[j];
+      if(prev[k]>=0 && si<=smax[k])
+	fct(data,prev[k],i);
+      if(sm>smax[k])
+	smax[k]=sm;
+      prev[k]=i;
+    }
+  }
+  ctx_unload(c);
+}
+
+/**
+ * Computes the Dahlhaus graph, using the tables of 'c'. The SL index is
+ * built, or taken in 'c', and kept for the subgraph builder.
+ * Time: O(f->size + \sum_i f->set[i].size)
+ */
+void graph_dahlhaus_create_ctx(overlap_ctx_t *c,graph_t *g,const family_t *f)
+{
+  double t=f->stats?overlap_time():0;
+  STAT_PHASE(f->stats,PH_DAHLHAUS);
+  graph_create(g,f->size);
+  g->stats=f->stats;
+  graph_lend_edges(c,g);
+  dahlhaus_edges_sl(c,f,edge_to_graph,g);
+  stats_phase(f->stats,PH_DAHLHAUS,&t);
+  STAT_PHASE(f->stats,PH_GRAPH_SORT);
+  graph_sort_ctx(c,g);
+  stats_phase(f->stats,PH_GRAPH_SORT,&t);
+}
+
+/** 
+ * Computes the Dahlhaus graph 
+ * Time: O(f->grnd_size + \sum_i f->set[i].size)
+ */
+void graph_dahlhaus_create(graph_t *g,const family_t *f)
+{
+  overlap_ctx_t *c=overlap_ctx_create();
+  graph_dahlhaus_create_ctx(c,g,f);
+  overlap_ctx_free(c);
 }
 
-typedef struct quintuple_s {
+/**
+ * Quintuples, linked by indices in a table
+ */
+typedef struct {
   int left,right;
-  int x,y,maxx;
-  struct quintuple_s *next;
+  ov_idx_t x,y,maxx;
+  ov_idx_t next;
 } quintuple_t;
 
 /**
- * Reverse the order of a list of quintuples
+ * Reverse the order of the list of quintuples starting at '*q'
  * Time: O(size)
  */
-static void reverse_quintuple_list(quintuple_t **q)
+static void reverse_quintuple_list(quintuple_t *qt,ov_idx_t *q)
 {
-  quintuple_t *q2=NULL,*t;
-  while(*q) {
-    t=(*q)->next;
-    (*q)->next=q2;
+  ov_idx_t q2=-1,t;
+  while(*q>=0) {
+    t=qt[*q].next;
+    qt[*q].next=q2;
     q2=*q;
     *q=t;
   }
@@ -851,80 +1660,90 @@ static void reverse_quintuple_list(quintuple_t **q)
 }
 
 /**
- * Computes a subgraph of the overlap graph
- * Time: O(f->grnd_size + \sum_i f->set[i].size )
+ * Generates the edges of a subgraph of the overlap graph
+ * Time: O(f->size + \sum_i f->set[i].size )
  */
-void graph_subgraph_overlap_create(graph_t *g,const family_t *f)
+static void subgraph_overlap_edges(overlap_ctx_t *c,const family_t *f,edge_fct_t fct,void *data)
 {
-  int i;
+  int i,n;
   sl_t sl;
+  double t=f->stats?overlap_time():0;
 
-  quintuple_t **ql=NULL,**qr=NULL;
+  quintuple_t *qt;
+  ov_idx_t nq=0;
+  ov_idx_t *ql,*qr;
+  const int *size=f->sets.size;
+  const ov_idx_t *max=f->sets.max;
+
+  if(f->size==0) return;
+  ctx_load(c,f);
+  n=c->k;
   
   /* quintuples sorted by left and right */
-  ql=(quintuple_t **)malloc(f->grnd_size*sizeof(quintuple_t *));
-  qr=(quintuple_t **)malloc(f->grnd_size*sizeof(quintuple_t *));
+  qt=(quintuple_t*)ctx_buf(c,CTX_Q,(size_t)c->lstart[f->size],sizeof(quintuple_t),f->stats);
+  ql=(ov_idx_t*)ctx_buf(c,CTX_QL,(size_t)n,sizeof(ov_idx_t),f->stats);
+  qr=(ov_idx_t*)ctx_buf(c,CTX_QR,(size_t)n,sizeof(ov_idx_t),f->stats);
 
-  for(i=0;i<f->grnd_size;i++)
-    ql[i]=qr[i]=NULL;
+  for(i=0;i<n;i++)
+    ql[i]=qr[i]=-1;
 
-  graph_create(g,f->size);
-  sl_create(&sl,f);
+  sl_get(&sl,c,f);
+  stats_phase(f->stats,PH_SL,&t);
+  STAT_PHASE(f->stats,PH_SUBGRAPH);
 
   for(i=0;i<sl.size;i++) {
-    sl_elm_t *e=sl.t[i];
-    int x,maxx;
+    ov_idx_t e;
+    ov_idx_t x,maxx;
     int smax=-1;
-    while(e) {
-      int set=e->set;
-      if(f->sets[set].max>=0) 
-	graph_add_edge(g,set,f->sets[set].max);
+    for(e=sl.off[i];e<sl.off[i+1];e++) {
+      ov_idx_t set=sl.set[e];
+      ov_idx_t m=max[set];
+      if(m>=0) 
+	fct(data,set,m);
       
-      if(smax>=0 && f->sets[set].size<=smax && set!=maxx) {
+      if(smax>=0 && size[set]<=smax && set!=maxx) {
 	/* create the quintuple and put it into 'ql */
-	quintuple_t *p=(quintuple_t*)malloc(sizeof(quintuple_t));
-	p->left=f->sets[set].mleft;
-	p->right=f->sets[set].mright;
+	quintuple_t *p=qt+nq;
+	STAT_ADD(f->stats,quintuples,1);
+	p->left=c->loc[f->sets.mleft[set]];
+	p->right=c->loc[f->sets.mright[set]];
 	p->x=x;
 	p->y=set;
 	p->maxx=maxx;
 	p->next=ql[p->left];
-	ql[p->left]=p;
+	ql[p->left]=nq++;
       }
 
-      if(f->sets[set].max>=0 && f->sets[f->sets[set].max].size>smax) {
+      if(m>=0 && size[m]>smax) {
 	x=set;
-	maxx=f->sets[set].max;
-	smax=f->sets[f->sets[set].max].size;
+	maxx=m;
+	smax=size[m];
       }
-      
-      e=e->next;
     }
   }
 
   /* reverse the lists of quintiples: after that every list is sorted in <_LF*/
-  for(i=0;i<f->grnd_size;i++)
-    reverse_quintuple_list(&(ql[i]));
+  for(i=0;i<n;i++)
+    reverse_quintuple_list(qt,&(ql[i]));
   
   /* for every list, compare with SL(i) */
-  for(i=0;i<f->grnd_size;i++) {
-    quintuple_t *p=ql[i];
-    sl_elm_t *p2=sl.t[i];
+  for(i=0;i<n;i++) {
+    ov_idx_t p=ql[i];
+    ov_idx_t p2=sl.off[i],end=sl.off[i+1];
     
-    while(p) {
-      quintuple_t *t;
-      while(p2 && p2->set < p->y) p2=p2->next;
-      t=p->next;
-      if(p2 && p2->set==p->y) {
+    while(p>=0) {
+      ov_idx_t t=qt[p].next;
+      while(p2<end && sl.set[p2] < qt[p].y) p2++;
+      if(p2<end && sl.set[p2]==qt[p].y) {
 	/* if the element is in the list (BM(r,left(X))=1), put the quintiple
 	   in qr */
-	p->next=qr[p->right];
-	qr[p->right]=p;
-	p2=p2->next;
+	qt[p].next=qr[qt[p].right];
+	qr[qt[p].right]=p;
+	STAT_ADD(f->stats,quintuples_qr,1);
+	p2++;
       } else {
 	/* otherwise Y is adjacent to X */
-	graph_add_edge(g,p->y,p->x);
-	free(p);
+	fct(data,qt[p].y,qt[p].x);
       }
       
       p=t;
@@ -932,71 +1751,607 @@ void graph_subgraph_overlap_create(graph_t *g,const family_t *f)
   }
 
   /* reverse the lists of quintiples: after that every list is sorted in <_LF*/
-  for(i=0;i<f->grnd_size;i++)
-    reverse_quintuple_list(&(qr[i]));
+  for(i=0;i<n;i++)
+    reverse_quintuple_list(qt,&(qr[i]));
 
-  for(i=0;i<f->grnd_size;i++) {
-    quintuple_t *p=qr[i];
-    sl_elm_t *p2=sl.t[i];
+  for(i=0;i<n;i++) {
+    ov_idx_t p=qr[i];
+    ov_idx_t p2=sl.off[i],end=sl.off[i+1];
     
-    while(p) {
-      quintuple_t *t;
-      while(p2 && p2->set <p->y) p2=p2->next;
-      t=p->next;
-      if(p2 && p2->set==p->y) {
+    while(p>=0) {
+      while(p2<end && sl.set[p2] < qt[p].y) p2++;
+      if(p2<end && sl.set[p2]==qt[p].y) {
 	/* Y is adjacent to Max(X) */
-	graph_add_edge(g,p->y,p->maxx);
-	p2=p2->next;
+	fct(data,qt[p].y,qt[p].maxx);
+	p2++;
       } else {
 	/* Y is adjacent to X */
-	graph_add_edge(g,p->y,p->x);
+	fct(data,qt[p].y,qt[p].x);
       }
-      free(p);
       
-      p=t;
+      p=qt[p].next;
     }
   }
 
-  graph_sort(g);
+  ctx_unload(c);
+  stats_phase(f->stats,PH_SUBGRAPH,&t);
+}
 
-  sl_free(&sl);
+/**
+ * Computes a subgraph of the overlap graph, using the tables of 'c'
+ * Time: O(f->size + \sum_i f->set[i].size )
+ */
+void graph_subgraph_overlap_create_ctx(overlap_ctx_t *c,graph_t *g,const family_t *f)
+{
+  double t;
+  STAT_PHASE(f->stats,PH_SL);
+  graph_create(g,f->size);
+  g->stats=f->stats;
+  graph_lend_edges(c,g);
+  subgraph_overlap_edges(c,f,edge_to_graph,g);
+  t=f->stats?overlap_time():0;
+  STAT_PHASE(f->stats,PH_GRAPH_SORT);
+  graph_sort_ctx(c,g);
+  stats_phase(f->stats,PH_GRAPH_SORT,&t);
+}
 
-  free(ql);
-  free(qr);
+/**
+ * Computes a subgraph of the overlap graph
+ * Time: O(f->grnd_size + \sum_i f->set[i].size )
+ */
+void graph_subgraph_overlap_create(graph_t *g,const family_t *f)
+{
+  overlap_ctx_t *c=overlap_ctx_create();
+  graph_subgraph_overlap_create_ctx(c,g,f);
+  overlap_ctx_free(c);
 }
 
 /**
  * Compute a DFS in 'g' stating at vertex 'i'
  * 't' is the table of already visited vertices
  * 'p' is the number of the connected component
+ * 'stack' is a table of g->n vertices. 
+ * The DFS is iterative: a vertex is numbered when it is pushed, 
+ * so it is pushed only once.
  */
-static void dfs(const graph_t *g,int *t,int i,int p)
+static void dfs(const graph_t *g,ov_idx_t *t,ov_idx_t *stack,ov_idx_t i,ov_idx_t p)
 {
-  edge_t *e=g->t[i];
+  ov_idx_t s=0;
   if(t[i]) return;
   t[i]=p;
-  while(e) {
-    dfs(g,t,e->v,p);
-    e=e->next;
+  stack[s++]=i;
+  while(s) {
+    ov_idx_t j,v=stack[--s];
+    for(j=g->off[v];j<g->off[v+1];j++) {
+      ov_idx_t w=g->adj[j];
+      if(t[w]==0) {
+	t[w]=p;
+	stack[s++]=w;
+      }
+    }
   }
 }
 
 /**
  * Computes the connected components of 'g', and put them into 't'.
  * (each connected component has a different number).
+ * The stack of the DFS is taken in 'c'.
  * Returns the number of connected components
  */ 
-int graph_connected_components(const graph_t *g,int *t)
+ov_idx_t graph_connected_components_ctx(overlap_ctx_t *c,const graph_t *g,ov_idx_t *t)
 {
-  int i,p=0;
+  ov_idx_t i,p=0;
+  ov_idx_t *stack=(ov_idx_t*)ctx_buf(c,CTX_STACK,(size_t)g->n,sizeof(ov_idx_t),g->stats);
   
   for(i=0;i<g->n;i++) t[i]=0;
   
   for(i=0;i<g->n;i++)
     if(t[i]==0) {
       p++;
-      dfs(g,t,i,p);
+      dfs(g,t,stack,i,p);
+    }
+
+  return p;
+}
+
+/**
+ * Computes the connected components of 'g', and put them into 't'.
+ * (each connected component has a different number).
+ * Returns the number of connected components
+ */
+ov_idx_t graph_connected_components(const graph_t *g,ov_idx_t *t)
+{
+  overlap_ctx_t *c=overlap_ctx_create();
+  ov_idx_t p=graph_connected_components_ctx(c,g,t);
+  overlap_ctx_free(c);
+  return p;
+}
+
+/**
+ * Computes the overlap components of 'f' without building any graph:
+ * the edges of the Dahlhaus graph go straight into a union-find structure.
+ * 't' is indiced as f->sets after the call (f is sorted by compute_max), 
+ * components are numbered as by graph_connected_components.
+ * All the temporary tables are taken in 'c'.
+ * Returns the number of components.
+ * Time: O(f->size + \sum_i f->set[i].size)
+ */
+ov_idx_t compute_overlap_components_ctx(overlap_ctx_t *c,family_t *f,ov_idx_t *t)
+{
+  uf_t u;
+  ov_idx_t p;
+  double time;
+
+  family_clear(f);
+  compute_max_ctx(c,f);
+
+  time=f->stats?overlap_time():0;
+  STAT_PHASE(f->stats,PH_UF);
+  uf_init(&u,f->size,(ov_idx_t*)ctx_buf(c,CTX_UF,(size_t)f->size,sizeof(ov_idx_t),f->stats));
+  dahlhaus_edges(c,f,edge_to_uf,&u);
+  p=uf_labels(&u,t);
+  stats_phase(f->stats,PH_UF,&time);
+
+  return p;
+}
+
+/**
+ * Computes the overlap components of 'f' (see compute_overlap_components_ctx)
+ * Returns the number of components.
+ * Time: O(f->grnd_size + \sum_i f->set[i].size)
+ * Memory: O(f->grnd_size + f->size) besides the family
+ */
+ov_idx_t compute_overlap_components(family_t *f,ov_idx_t *t)
+{
+  overlap_ctx_t *c=overlap_ctx_create();
+  ov_idx_t p=compute_overlap_components_ctx(c,f,t);
+  overlap_ctx_free(c);
+  return p;
+}
+
+/**
+ * Computes the overlap components of 'f' with one engine (see overlap.h),
+ * after a single compute_max. The graph engines free their graph before
+ * returning. 't' and the numbers of the components are as in 
+ * compute_overlap_components_ctx.
+ * All the temporary tables are taken in 'c'.
+ * Returns the number of components, or -1 if 'engine' is unknown.
+ * Time: O(f->size + \sum_i f->set[i].size)
+ */
+ov_idx_t compute_overlap_components_engine_ctx(overlap_ctx_t *c,family_t *f,ov_idx_t *t,int engine)
+{
+  graph_t g;
+  ov_idx_t p;
+
+  if(engine==OVERLAP_ENGINE_UF)
+    return compute_overlap_components_ctx(c,f,t);
+  if(engine!=OVERLAP_ENGINE_DAHLHAUS && engine!=OVERLAP_ENGINE_SUBGRAPH)
+    return -1;
+
+  family_clear(f);
+  compute_max_ctx(c,f);
+  if(engine==OVERLAP_ENGINE_DAHLHAUS)
+    graph_dahlhaus_create_ctx(c,&g,f);
+  else
+    graph_subgraph_overlap_create_ctx(c,&g,f);
+  p=graph_connected_components_ctx(c,&g,t);
+  graph_free(&g);
+  return p;
+}
+
+/**
+ * Computes the overlap components of 'f' with one engine
+ * (see compute_overlap_components_engine_ctx)
+ * Returns the number of components, or -1 if 'engine' is unknown.
+ * Time: O(f->grnd_size + \sum_i f->set[i].size)
+ */
+ov_idx_t compute_overlap_components_engine(family_t *f,ov_idx_t *t,int engine)
+{
+  overlap_ctx_t *c=overlap_ctx_create();
+  ov_idx_t p=compute_overlap_components_engine_ctx(c,f,t,engine);
+  overlap_ctx_free(c);
+  return p;
+}
+
+/**
+ * Create empty groups
+ */
+void overlap_groups_init(overlap_groups_t *g)
+{
+  g->n=0;
+  g->off=g->sets=NULL;
+  g->off_cap=g->sets_cap=0;
+}
+
+void overlap_groups_free(overlap_groups_t *g)
+{
+  free(g->off);
+  free(g->sets);
+}
+
+/**
+ * Group the sets of 'f' by component, given 'nc' components numbered
+ * 1..nc in 't' (indiced as f->sets, as given by graph_connected_components
+ * or compute_overlap_components). 
+ * One counting sort of the identifiers, the temporary tables are taken
+ * in 'c'.
+ * Time: O(f->size + nc)
+ */
+void overlap_groups_build_ctx(overlap_ctx_t *c,overlap_groups_t *g,const family_t *f,const ov_idx_t *t,ov_idx_t nc)
+{
+  ov_idx_t i,q,n=f->size;
+  ov_idx_t *lab=(ov_idx_t*)ctx_buf(c,CTX_GRP_LAB,(size_t)n,sizeof(ov_idx_t),f->stats);
+  ov_idx_t *num=(ov_idx_t*)ctx_buf(c,CTX_GRP_NUM,(size_t)nc+1,sizeof(ov_idx_t),f->stats);
+
+  if(nc+1>g->off_cap) {
+    g->off_cap=nc+1;
+    g->off=(ov_idx_t*)realloc(g->off,sizeof(ov_idx_t)*(size_t)g->off_cap);
+  }
+  if(n>g->sets_cap) {
+    g->sets_cap=n;
+    g->sets=(ov_idx_t*)realloc(g->sets,sizeof(ov_idx_t)*(size_t)g->sets_cap);
+  }
+
+  /* component of every identifier, renumbered by smallest identifier */
+  for(i=0;i<n;i++)
+    lab[f->sets.id[i]]=t[i];
+  for(q=0;q<=nc;q++)
+    num[q]=-1;
+  for(i=0,q=0;i<n;i++) {
+    if(num[lab[i]]<0)
+      num[lab[i]]=q++;
+    lab[i]=num[lab[i]];
+  }
+  assert(q==nc);
+
+  /* by component, in increasing identifier */
+  counting_sort(c,n,NULL,lab,nc-1,g->off,g->sets,0,f->stats);
+  g->n=nc;
+}
+
+/**
+ * Group the sets of 'f' by component (see overlap_groups_build_ctx)
+ * Time: O(f->size + nc)
+ */
+void overlap_groups_build(overlap_groups_t *g,const family_t *f,const ov_idx_t *t,ov_idx_t nc)
+{
+  overlap_ctx_t *c=overlap_ctx_create();
+  overlap_groups_build_ctx(c,g,f,t,nc);
+  overlap_ctx_free(c);
+}
+
+/**
+ * Computes the overlap components of 'f' as groups of sets (see 
+ * compute_overlap_components_ctx and overlap_groups_build_ctx).
+ * All the temporary tables are taken in 'c'.
+ * Returns the number of components.
+ * Time: O(f->size + \sum_i f->set[i].size)
+ */
+ov_idx_t compute_overlap_groups_ctx(overlap_ctx_t *c,family_t *f,overlap_groups_t *g)
+{
+  ov_idx_t *t=(ov_idx_t*)ctx_buf(c,CTX_GRP_T,(size_t)f->size,sizeof(ov_idx_t),f->stats);
+  ov_idx_t nc=compute_overlap_components_ctx(c,f,t);
+  overlap_groups_build_ctx(c,g,f,t,nc);
+  return nc;
+}
+
+/**
+ * Computes the overlap components of 'f' as groups of sets
+ * Returns the number of components.
+ * Time: O(f->grnd_size + \sum_i f->set[i].size)
+ */
+ov_idx_t compute_overlap_groups(family_t *f,overlap_groups_t *g)
+{
+  overlap_ctx_t *c=overlap_ctx_create();
+  ov_idx_t nc=compute_overlap_groups_ctx(c,f,g);
+  overlap_ctx_free(c);
+  return nc;
+}
+
+/**
+ * Spanning forest of the overlap graph, with its certificate: an edge
+ * which would merge two classes of 'u' is kept in cert[m] if its sets 
+ * overlap. 'mark' is 0 on the ground set.
+ * The pairs of the builder to test are small[k],large[k] (k<np), with 
+ * |small[k]| <= |large[k]|.
+ */
+typedef struct {
+  overlap_ctx_t *c;
+  const family_t *f;
+  uf_t u;
+  overlap_cert_t *cert;
+  ov_idx_t m;
+  int *mark;
+  ov_idx_t np;
+  ov_idx_t *small,*large;
+} forest_t;
+
+/**
+ * Keeps the edge (a,b) with its witnesses in the forest.
+ * Time: O(1) amortized
+ */
+static void forest_keep(forest_t *fo,ov_idx_t a,ov_idx_t b,int in,int ab,int ba)
+{
+  overlap_cert_t *x=fo->cert+fo->m++;
+  x->a=a;
+  x->b=b;
+  x->in=in;
+  x->ab=ab;
+  x->ba=ba;
+  uf_union(&fo->u,a,b);
+}
+
+/**
+ * Finds an element of 'x' in 'y' and an element of 'x' not in 'y' 
+ * (or -1). 'mark' is 0 on the ground set, and is 0 again after the call.
+ * Time: O(|x|+|y|)
+ */
+static void witness(const family_t *f,int *mark,ov_idx_t x,ov_idx_t y,int *in,int *out)
+{
+  const int *sx=family_set(f,x),*sy=family_set(f,y);
+  int j;
+  *in=*out=-1;
+  for(j=0;j<f->sets.size[y];j++)
+    mark[sy[j]]=1;
+  for(j=0;j<f->sets.size[x] && (*in<0 || *out<0);j++) {
+    if(mark[sx[j]]) *in=sx[j];
+    else *out=sx[j];
+  }
+  for(j=0;j<f->sets.size[y];j++)
+    mark[sy[j]]=0;
+}
+
+/**
+ * Adds the edge (i,j) to the forest if 'i' and 'j' overlap.
+ * Returns 1 if the edge is added.
+ * Time: O(|i|+|j|)
+ */
+static int forest_add(forest_t *fo,ov_idx_t i,ov_idx_t j)
+{
+  int in,ab,ba;
+  witness(fo->f,fo->mark,i,j,&in,&ab);
+  if(in<0 || ab<0) return 0;
+  witness(fo->f,fo->mark,j,i,&in,&ba);
+  if(ba<0) return 0;
+  forest_keep(fo,i,j,in,ab,ba);
+  return 1;
+}
+
+/**
+ * Adds the edges (x,Max(x)) to the forest. Max(x) splits x (see 
+ * compute_max): mright[x] is in Max(x) and mleft[x] is not, so only an
+ * element of Max(x) not in x is searched. Since |Max(x)| >= |x| and at
+ * most |x|-1 elements of x are in Max(x), it is among the |x| first 
+ * elements of Max(x).
+ * Time: O(f->size + \sum_i f->set[i].size)
+ */
+static void forest_max(forest_t *fo)
+{
+  const family_t *f=fo->f;
+  ov_idx_t x;
+  int j;
+  for(x=0;x<f->size;x++) {
+    ov_idx_t y=f->sets.max[x];
+    const int *sx=family_set(f,x),*sy;
+    if(y<0 || uf_find(&fo->u,x)==uf_find(&fo->u,y)) continue;
+    sy=family_set(f,y);
+    for(j=0;j<f->sets.size[x];j++)
+      fo->mark[sx[j]]=1;
+    for(j=0;j<f->sets.size[x] && fo->mark[sy[j]];j++) ;
+    assert(j<f->sets.size[x]);
+    forest_keep(fo,x,y,f->sets.mright[x],f->sets.mleft[x],sy[j]);
+    for(j=0;j<f->sets.size[x];j++)
+      fo->mark[sx[j]]=0;
+  }
+}
+
+/**
+ * Keeps the edges of the builder which are not (x,Max(x)) and would 
+ * merge two classes, to be tested by forest_pairs.
+ * Time: O(1) amortized
+ */
+static void edge_to_pairs(void *data,ov_idx_t i,ov_idx_t j)
+{
+  forest_t *fo=(forest_t*)data;
+  const family_t *f=fo->f;
+  if(f->sets.max[i]==j || f->sets.max[j]==i 
+     || uf_find(&fo->u,i)==uf_find(&fo->u,j)) 
+    return;
+  fo->small=(ov_idx_t*)ctx_buf(fo->c,CTX_CERT_SMALL,(size_t)fo->np+1,sizeof(ov_idx_t),f->stats);
+  fo->large=(ov_idx_t*)ctx_buf(fo->c,CTX_CERT_LARGE,(size_t)fo->np+1,sizeof(ov_idx_t),f->stats);
+  if(f->sets.size[i]<=f->sets.size[j]) {
+    fo->small[fo->np]=i;
+    fo->large[fo->np]=j;
+  } else {
+    fo->small[fo->np]=j;
+    fo->large[fo->np]=i;
+  }
+  fo->np++;
+}
+
+/**
+ * Tests the pairs kept by edge_to_pairs, grouped by their larger set L: 
+ * L is marked once for its group, and a pair (S,L) costs O(|S|). The 
+ * elements of S in L are marked 2, so an element of L not in S is among
+ * the |S \cap L|+1 first elements of L.
+ * Time: O(f->size + \sum_{L} |L| + \sum_{(S,L) tested} |S|)
+ */
+static void forest_pairs(forest_t *fo)
+{
+  const family_t *f=fo->f;
+  ov_idx_t k,*off,*order;
+  int j;
+  if(fo->np==0) return;
+  off=(ov_idx_t*)ctx_buf(fo->c,CTX_CERT_OFF,(size_t)f->size+1,sizeof(ov_idx_t),f->stats);
+  order=(ov_idx_t*)ctx_buf(fo->c,CTX_CERT_ORDER,(size_t)fo->np,sizeof(ov_idx_t),f->stats);
+  counting_sort(fo->c,fo->np,NULL,fo->large,f->size-1,off,order,0,f->stats);
+  for(k=0;k<fo->np;) {
+    ov_idx_t l=fo->large[order[k]],e;
+    const int *sl=family_set(f,l);
+    for(j=0;j<f->sets.size[l];j++)
+      fo->mark[sl[j]]=1;
+    for(e=off[l+1];k<e;k++) {
+      ov_idx_t s=fo->small[order[k]];
+      const int *ss=family_set(f,s);
+      int in=-1,ab=-1;
+      if(uf_find(&fo->u,s)==uf_find(&fo->u,l)) continue;
+      for(j=0;j<f->sets.size[s];j++) {
+	if(fo->mark[ss[j]]) {
+	  in=ss[j];
+	  fo->mark[ss[j]]=2;
+	} else 
+	  ab=ss[j];
+      }
+      if(in>=0 && ab>=0) {
+	for(j=0;fo->mark[sl[j]]==2;j++) ;
+	forest_keep(fo,s,l,in,ab,sl[j]);
+      }
+      for(j=0;j<f->sets.size[s];j++)
+	if(fo->mark[ss[j]]==2)
+	  fo->mark[ss[j]]=1;
+    }
+    for(j=0;j<f->sets.size[l];j++)
+      fo->mark[sl[j]]=0;
+  }
+}
+
+/**
+ * Completes the forest in the components of 'u' (the overlap components)
+ * which are split into many trees: the pairs of sets of these components
+ * which share an element are tested, with an inverted index of their 
+ * elements, until every component is a single tree.
+ * Time: O(f->grnd_size + f->size + \sum_{A split} \sum_{e in A} |{B split: e in B}|)
+ */
+static void forest_repair(overlap_ctx_t *c,forest_t *fo,uf_t *u)
+{
+  const family_t *f=fo->f;
+  ov_idx_t i,j,k,n=f->size,ns=0,nl=0;
+  ov_idx_t *pieces=(ov_idx_t*)ctx_buf(c,CTX_CERT_PIECES,(size_t)n,sizeof(ov_idx_t),f->stats);
+  ov_idx_t *sets,*idx,*list,*co,*touch;
+
+  /* number of trees in every component, and the sets of the split ones */
+  for(i=0;i<n;i++)
+    pieces[i]=0;
+  for(i=0;i<n;i++)
+    if(fo->u.p[i]<0) 
+      pieces[uf_find(u,i)]++;
+  sets=(ov_idx_t*)ctx_buf(c,CTX_CERT_SETS,(size_t)n,sizeof(ov_idx_t),f->stats);
+  for(i=0;i<n;i++)
+    if(pieces[uf_find(u,i)]>1) {
+      sets[ns++]=i;
+      nl+=f->sets.size[i];
     }
 
+  /* inverted index: the split sets containing the element e are 
+     list[idx[e] .. idx[e+1]-1] */
+  idx=(ov_idx_t*)ctx_buf(c,CTX_CERT_IDX,(size_t)f->grnd_size+1,sizeof(ov_idx_t),f->stats);
+  list=(ov_idx_t*)ctx_buf(c,CTX_CERT_LIST,(size_t)nl,sizeof(ov_idx_t),f->stats);
+  for(i=0;i<=f->grnd_size;i++)
+    idx[i]=0;
+  for(k=0;k<ns;k++) {
+    const int *set=family_set(f,sets[k]);
+    for(j=0;j<f->sets.size[sets[k]];j++)
+      idx[set[j]+1]++;
+  }
+  for(i=0;i<f->grnd_size;i++)
+    idx[i+1]+=idx[i];
+  for(k=0;k<ns;k++) {
+    const int *set=family_set(f,sets[k]);
+    for(j=0;j<f->sets.size[sets[k]];j++)
+      list[idx[set[j]]++]=sets[k];
+  }
+  for(i=f->grnd_size;i>0;i--)
+    idx[i]=idx[i-1];
+  idx[0]=0;
+
+  /* co[B] = |A \cap B| for the sets B touched by A */
+  co=(ov_idx_t*)ctx_buf(c,CTX_CERT_CO,(size_t)n,sizeof(ov_idx_t),f->stats);
+  touch=(ov_idx_t*)ctx_buf(c,CTX_CERT_TOUCH,(size_t)n,sizeof(ov_idx_t),f->stats);
+  for(i=0;i<n;i++)
+    co[i]=0;
+  for(k=0;k<ns;k++) {
+    ov_idx_t a=sets[k],r=uf_find(u,a),nt=0;
+    const int *set=family_set(f,a);
+    if(pieces[r]<=1) continue;
+    for(j=0;j<f->sets.size[a];j++) {
+      ov_idx_t l;
+      for(l=idx[set[j]];l<idx[set[j]+1];l++)
+	if(list[l]!=a && co[list[l]]++==0)
+	  touch[nt++]=list[l];
+    }
+    for(j=0;j<nt;j++) {
+      ov_idx_t b=touch[j];
+      if(co[b]<f->sets.size[a] && co[b]<f->sets.size[b] 
+	 && uf_find(&fo->u,a)!=uf_find(&fo->u,b) && forest_add(fo,a,b))
+	pieces[r]--;
+      co[b]=0;
+    }
+  }
+}
+
+/**
+ * Computes the overlap components of 'f' with a certificate: 'cert' gets
+ * the f->size-nc edges of a spanning forest of the overlap graph, with 
+ * their witness elements, through a union-find structure. The edges 
+ * (X,Max(X)) come first, with witnesses from the refinements 
+ * (forest_max), then the other edges of the subgraph of the overlap graph
+ * (forest_pairs). The builder also gives edges between nested sets of a 
+ * same component: an edge is only kept if its sets overlap, which is 
+ * checked when it would merge two classes. Without these edges a component may be split into many trees: they 
+ * are joined by forest_repair, in the components given by the Dahlhaus
+ * graph.
+ * 't' and the sets of 'cert' are indiced as f->sets after the call (f is
+ * sorted by compute_max), components are numbered as by 
+ * compute_overlap_components_ctx. 'cert' has room for f->size entries.
+ * See overlap_cert_check to verify the result.
+ * All the temporary tables are taken in 'c'.
+ * Returns the number of components (nc).
+ * Time: O(f->size + \sum_i f->set[i].size + \sum_{(S,L) tested} |S|),
+ * with |S| <= |L| for the edges which are not (X,Max(X)), plus 
+ * forest_repair on the split components
+ */
+ov_idx_t compute_overlap_certificates_ctx(overlap_ctx_t *c,family_t *f,ov_idx_t *t,overlap_cert_t *cert)
+{
+  forest_t fo;
+  uf_t u;
+  ov_idx_t i,p,nc=0;
+
+  family_clear(f);
+  compute_max_ctx(c,f);
+
+  fo.c=c;
+  fo.f=f;
+  uf_init(&fo.u,f->size,(ov_idx_t*)ctx_buf(c,CTX_UF,(size_t)f->size,sizeof(ov_idx_t),f->stats));
+  fo.cert=cert;
+  fo.m=0;
+  fo.mark=ctx_table(c,CTX_MARK,f->grnd_size,0,f->stats);
+  fo.np=0;
+  forest_max(&fo);
+  subgraph_overlap_edges(c,f,edge_to_pairs,&fo);
+  forest_pairs(&fo);
+
+  uf_init(&u,f->size,(ov_idx_t*)ctx_buf(c,CTX_CERT_UF,(size_t)f->size,sizeof(ov_idx_t),f->stats));
+  dahlhaus_edges(c,f,edge_to_uf,&u);
+  for(i=0;i<f->size;i++)
+    if(u.p[i]<0) nc++;
+  if(fo.m<f->size-nc)
+    forest_repair(c,&fo,&u);
+
+  p=uf_labels(&fo.u,t);
+  assert(p==nc && fo.m==f->size-p);
   return p;
 }
+
+/**
+ * Computes the overlap components of 'f' with a certificate
+ * (see compute_overlap_certificates_ctx).
+ * Returns the number of components.
+ * Time: O(f->grnd_size + \sum_i f->set[i].size + \sum_{(A,B) in cert} |A|+|B|)
+ */
+ov_idx_t compute_overlap_certificates(family_t *f,ov_idx_t *t,overlap_cert_t *cert)
+{
+  overlap_ctx_t *c=overlap_ctx_create();
+  ov_idx_t nc=compute_overlap_certificates_ctx(c,f,t,cert);
+  overlap_ctx_free(c);
+  return nc;
+}
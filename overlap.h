@@ -20,55 +20,236 @@
 #ifndef _OVERLAP_H_
 #define _OVERLAP_H_
 
+/*
+ * Index type of the core: indices and numbers of sets, positions in the 
+ * table of elements (so \sum_i |X_i|), vertices and edges of the graphs,
+ * labels of the components. 
+ * It is an int by default, and a long long if compiled with 
+ * -DOVERLAP_INDEX64 (make INDEX=-DOVERLAP_INDEX64), for families beyond 
+ * 2^31 elements. The elements themselves (and set sizes) stay int.
+ */
+#ifdef OVERLAP_INDEX64
+typedef long long ov_idx_t;
+#define OV_IDX_MAX 0x7fffffffffffffffLL
+#else
+typedef int ov_idx_t;
+#define OV_IDX_MAX 0x7fffffff
+#endif
+
+/* phases of the computation, for profiling */
+enum {
+  PH_SORT, /* family_sort */
+  PH_REFINE1, /* 1st refining */
+  PH_LEFTRIGHT, /* left and right of the sets */
+  PH_AM, /* am_create */
+  PH_REFINE2, /* 2nd refining (Maxs) */
+  PH_SL, /* sl_create */
+  PH_DAHLHAUS, /* edges of the Dahlhaus graph */
+  PH_SUBGRAPH, /* edges of the subgraph of the overlap graph */
+  PH_GRAPH_SORT, /* graph_sort */
+  PH_UF, /* union-find of compute_overlap_components */
+  PH_CC, /* connected components (timed by the caller) */
+  PH_NBR
+};
+
+/**
+ * Profiling data, filled by compute_max and the graph builders if 
+ * family_t.stats is set.
+ * Counters are only maintained when the library is compiled with 
+ * -DOVERLAP_STATS (see overlap_stats_enabled), otherwise they cost nothing.
+ */
+typedef struct {
+  double time[PH_NBR]; /* seconds spent in each phase (accumulated) */
+
+  long long refine; /* calls to refine */
+  long long xcg; /* exchanges in the refine structure */
+  long long classes; /* classes created in the refine structure */
+  long long fct_test; /* calls to fct_test */
+  long long am_advance; /* advances of the pointers of the AM structure */
+  long long quintuples; /* quintuples created */
+  long long quintuples_qr; /* quintuples put into qr */
+  long long edges; /* edges given to graph_add_edge */
+  long long edges_sorted; /* edges after graph_sort (no multiple edges) */
+  long long allocs[PH_NBR]; /* calls to malloc/realloc in each phase */
+  long long bytes[PH_NBR]; /* bytes allocated in each phase */
+  int phase; /* current phase, for allocs and bytes */
+} overlap_stats_t;
+
+extern const int overlap_stats_enabled;
+extern const char *overlap_phase_name[PH_NBR];
+extern double overlap_time(void);
+
+/**
+ * Context: the scratch tables used by compute_max, the graph builders and
+ * the connected components. They only grow, and are reset in time 
+ * proportional to what was used, so the *_ctx functions can be called 
+ * back-to-back on many families without allocating anything but their 
+ * results. The functions without a context create a temporary one.
+ * A context must not be used by two calls at the same time.
+ */
+typedef struct overlap_ctx_s overlap_ctx_t;
+
+extern overlap_ctx_t *overlap_ctx_create(void);
+extern void overlap_ctx_free(overlap_ctx_t *c);
+extern void overlap_ctx_set_threads(overlap_ctx_t *c,int nthreads);
+
+/**
+ * The data of one set (see family_get_set).
+ */
 typedef struct {
   int size;
-  int *set;
+  ov_idx_t start; /* indice of the first element of the set in family_t.elms */
 
   int left,right;
   int mleft,mright;
-  int max; /* -1 : undef */
-  int ampos; 
-  int id;
+  ov_idx_t max; /* -1 : undef */
+  ov_idx_t ampos; 
+  ov_idx_t id;
 } set_t;
 
+/**
+ * The data of the sets of a family, one table per field: the i-th set 
+ * is size[i], start[i]... so that every pass only loads the fields it uses.
+ */
 typedef struct {
-  int size;
+  int *size;
+  ov_idx_t *start; /* indice of the first element of the set in family_t.elms */
+
+  int *left,*right; /* set by compute_max */
+  int *mleft,*mright; /* idem, elements of the ground set */
+  ov_idx_t *max; /* -1 : undef */
+  ov_idx_t *ampos; /* position in the AM structure of compute_max */
+  ov_idx_t *id; /* order of insertion */
+} family_sets_t;
+
+/**
+ * A family of sets.
+ * The elements of all the sets are stored in one table 'elms' (CSR layout):
+ * the elements of the i-th set are elms[sets.start[i] .. sets.start[i]+sets.size[i]-1].
+ * The tables of 'sets' and 'elms' grow geometrically.
+ */
+typedef struct {
+  ov_idx_t size;
   int grnd_size;
-  set_t *sets;
+  family_sets_t sets;
+  ov_idx_t sets_cap; /* allocated size of the tables of 'sets' */
+
+  int *elms;
+  ov_idx_t elms_size; /* \sum_i sets.size[i] */
+  ov_idx_t elms_cap; /* allocated size of 'elms' */
+  int borrowed; /* 1 if 'elms' is owned by the caller (see family_view) */
   
-  int *grnd_count; /* always equal to 0 */
+  int *grnd_count; /* always equal to 0. NULL for a view or if 'ctx' is set */
+  overlap_ctx_t *ctx; /* the context giving grnd_count (see family_create_ctx) */
+
+  overlap_stats_t *stats; /* NULL, or profiling data to fill */
+  unsigned long stamp; /* changed by every change of the sets */
 } family_t;
 
+/* the table of elements of the i-th set of 'f' */
+#define family_set(f,i) ((f)->elms+(f)->sets.start[i])
+
 extern void family_create(family_t *f,int grnd_size);
+extern void family_create_ctx(overlap_ctx_t *c,family_t *f,int grnd_size);
+extern int family_view(family_t *f,int grnd_size,ov_idx_t nbr, const ov_idx_t *offsets, const int *elms);
+extern int family_adopt(family_t *f,int grnd_size,ov_idx_t nbr, const ov_idx_t *offsets, int *elms);
 extern void family_free(family_t *f);
+extern set_t family_get_set(const family_t *f,ov_idx_t i);
 extern void family_clear(family_t *f);
-extern int family_add_set(family_t *f,int size, const int *set);
+extern ov_idx_t family_add_set(family_t *f,int size, const int *set);
+extern ov_idx_t family_add_sets_bulk(family_t *f,ov_idx_t nbr, const ov_idx_t *offsets, const int *elms);
+extern int family_check_sets_ctx(overlap_ctx_t *c,const family_t *f);
 extern int family_check_sort(const family_t *f);
 extern void family_sort(family_t *f);
+extern void family_sort_ctx(overlap_ctx_t *c,family_t *f);
 extern void family_print(const family_t *f);
 
 extern void compute_max(family_t *f);
+extern void compute_max_ctx(overlap_ctx_t *c,family_t *f);
 
 
-typedef struct edge_s {
-  int v;
-  struct edge_s *next;
-} edge_t;
-
+/**
+ * A graph in CSR form: once graph_sort has been called, the neighbours of 
+ * 'i' are adj[off[i] .. off[i+1]-1], in increasing order and without 
+ * multiple edges.
+ * graph_add_edge only appends the edge to the buffer 'edges'. 
+ * graph_sort moves them into the CSR tables.
+ */
 typedef struct  {
-  int n;
-  edge_t **t;
+  ov_idx_t n;
+  ov_idx_t *off; /* n+1 entries */
+  ov_idx_t *adj;
+
+  ov_idx_t *edges; /* edges added since the last graph_sort: edges[2k]-edges[2k+1] */
+  ov_idx_t nedges;
+  ov_idx_t edges_cap; /* allocated number of edges in 'edges' */
+
+  overlap_stats_t *stats; /* NULL, or profiling data to fill */
 } graph_t;
 
 extern void graph_free(graph_t *g);
-extern void graph_create(graph_t *g,int);
+extern void graph_create(graph_t *g,ov_idx_t);
 extern void graph_dahlhaus_create(graph_t *g,const family_t *f);
+extern void graph_dahlhaus_create_ctx(overlap_ctx_t *c,graph_t *g,const family_t *f);
 extern void graph_print(const graph_t *g);
 extern void graph_sort(graph_t *g);
-extern void graph_add_edge(graph_t *g,int i,int j);
+extern void graph_sort_ctx(overlap_ctx_t *c,graph_t *g);
+extern void graph_add_edge(graph_t *g,ov_idx_t i,ov_idx_t j);
 
 extern void graph_subgraph_overlap_create(graph_t *g,const family_t *f);
-extern int graph_connected_components(const graph_t *g,int *t);
+extern void graph_subgraph_overlap_create_ctx(overlap_ctx_t *c,graph_t *g,const family_t *f);
+extern ov_idx_t graph_connected_components(const graph_t *g,ov_idx_t *t);
+extern ov_idx_t graph_connected_components_ctx(overlap_ctx_t *c,const graph_t *g,ov_idx_t *t);
+
+extern ov_idx_t compute_overlap_components(family_t *f,ov_idx_t *t);
+extern ov_idx_t compute_overlap_components_ctx(overlap_ctx_t *c,family_t *f,ov_idx_t *t);
+
+/*
+ * Engines of compute_overlap_components_engine
+ */
+#define OVERLAP_ENGINE_UF 0 /* Dahlhaus edges into a union-find structure */
+#define OVERLAP_ENGINE_DAHLHAUS 1 /* Dahlhaus graph, then its components */
+#define OVERLAP_ENGINE_SUBGRAPH 2 /* subgraph of the overlap graph, then its components */
+
+extern ov_idx_t compute_overlap_components_engine(family_t *f,ov_idx_t *t,int engine);
+extern ov_idx_t compute_overlap_components_engine_ctx(overlap_ctx_t *c,family_t *f,ov_idx_t *t,int engine);
+
+/**
+ * Components as groups of sets, in CSR form: the sets of the component q
+ * are sets[off[q] .. off[q+1]-1], given by their identifier (family_sets_t.id, 
+ * i.e. the order of insertion) in increasing order. Components are 
+ * numbered from 0 in the order of their smallest identifier.
+ * The tables are reused by the next build on the same structure.
+ */
+typedef struct {
+  ov_idx_t n; /* number of components */
+  ov_idx_t *off; /* n+1 entries */
+  ov_idx_t *sets; /* off[n] entries */
+  ov_idx_t off_cap,sets_cap; /* allocated sizes of 'off' and 'sets' */
+} overlap_groups_t;
+
+/* number of sets of the component q */
+#define overlap_group_size(g,q) ((g)->off[(q)+1]-(g)->off[(q)])
+
+extern void overlap_groups_init(overlap_groups_t *g);
+extern void overlap_groups_free(overlap_groups_t *g);
+extern void overlap_groups_build(overlap_groups_t *g,const family_t *f,const ov_idx_t *t,ov_idx_t nc);
+extern void overlap_groups_build_ctx(overlap_ctx_t *c,overlap_groups_t *g,const family_t *f,const ov_idx_t *t,ov_idx_t nc);
+extern ov_idx_t compute_overlap_groups(family_t *f,overlap_groups_t *g);
+extern ov_idx_t compute_overlap_groups_ctx(overlap_ctx_t *c,family_t *f,overlap_groups_t *g);
+
+/**
+ * Certificate of an edge of the overlap graph: the sets 'a' and 'b'
+ * (indices in f->sets) overlap, as shown by 'in' in a and b, 'ab' in a
+ * and not in b, and 'ba' in b and not in a.
+ */
+typedef struct {
+  ov_idx_t a,b;
+  int in,ab,ba;
+} overlap_cert_t;
+
+extern ov_idx_t compute_overlap_certificates(family_t *f,ov_idx_t *t,overlap_cert_t *cert);
+extern ov_idx_t compute_overlap_certificates_ctx(overlap_ctx_t *c,family_t *f,ov_idx_t *t,overlap_cert_t *cert);
 
 #endif
 
@@ -0,0 +1,162 @@
+/*
+ *   This source file is part of program computing set overlap classes 
+ *   in linear time.
+ *   Copyright (C) 2007  Michael Rao
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdlib.h>
+#include <assert.h>
+#include "prepass.h"
+#include "remap.h"
+
+/*
+ * Prepass: sets which cannot change the overlap components are removed
+ * before the computation.
+ * - A set of size 1, or equal to the ground set, overlaps no set: it is 
+ *   a component by itself.
+ * - Equal sets overlap the same sets, and not each other: only one 
+ *   representative is kept. The others are in its component if it 
+ *   overlaps a set, otherwise each one is a component by itself.
+ * Equal sets are found by a hash of their content which does not depend on
+ * the order of the elements (the sum of the hashes of the elements), and 
+ * checked element by element. A set whose hash is already taken by a 
+ * different set is simply kept.
+ */
+
+/**
+ * Hash of the content of a set
+ * Time: O(size)
+ */
+static remap_id_t prepass_hash(const int *set,int size)
+{
+  remap_id_t h=0;
+  int i;
+  for(i=0;i<size;i++)
+    h+=remap_hash((remap_id_t)set[i]);
+  return remap_hash(h^(remap_id_t)size);
+}
+
+/**
+ * Returns 1 if the sets 'a' and 'b' of 'f' are equal.
+ * 'count' has f->grnd_size entries, all equal to 0 (they are reset).
+ * Time: O(|a|+|b|)
+ */
+static int prepass_equal(const family_t *f,int *count,ov_idx_t a,ov_idx_t b)
+{
+  const int *sa=family_set(f,a),*sb=family_set(f,b);
+  int i,eq=1;
+  if(f->sets.size[a]!=f->sets.size[b]) return 0;
+  for(i=0;i<f->sets.size[a];i++)
+    count[sa[i]]=1;
+  for(i=0;i<f->sets.size[b] && eq;i++)
+    eq=count[sb[i]];
+  for(i=0;i<f->sets.size[a];i++)
+    count[sa[i]]=0;
+  return eq;
+}
+
+/**
+ * Computes the overlap components of 'f' on the reduced family (see 
+ * above), using the tables of 'c'. 'f' is not changed.
+ * 't' is indiced by the identifiers of the sets (f->sets.id), components
+ * are numbered from 1 in the order of their smallest identifier.
+ * 'st' (may be NULL) is filled with the size of the reduction.
+ * Returns the number of components.
+ * Time: O(f->grnd_size + \sum_i f->set[i].size) expected
+ */
+ov_idx_t prepass_components(overlap_ctx_t *c,const family_t *f,ov_idx_t *t,prepass_stats_t *st)
+{
+  ov_idx_t n=f->size,i,j,nc,p=0;
+  ov_idx_t *rep=(ov_idx_t*)malloc(sizeof(ov_idx_t)*(size_t)(n>0?n:1));
+  ov_idx_t *lab=(ov_idx_t*)malloc(sizeof(ov_idx_t)*(size_t)(n>0?n:1));
+  ov_idx_t *first=(ov_idx_t*)malloc(sizeof(ov_idx_t)*(size_t)(n>0?n:1));
+  int *count=(int*)calloc(f->grnd_size>0?f->grnd_size:1,sizeof(int));
+  prepass_stats_t s={0,0,0};
+  ov_idx_t *num,*size;
+  family_t r;
+  remap_t m;
+
+  /* rep[i]: i if the set is kept, -1 if it is set aside, otherwise the 
+     kept set equal to it */
+  remap_init(&m);
+  for(i=0;i<n;i++) {
+    int size=f->sets.size[i];
+    int h,k;
+    if(size==1 || size==f->grnd_size) {
+      rep[i]=-1;
+      s.naside++;
+      continue;
+    }
+    rep[i]=i;
+    k=m.k;
+    h=remap_get(&m,prepass_hash(family_set(f,i),size));
+    if(h<0)
+      continue; /* the table is full: keep the set */
+    if(m.k>k) /* a new key */
+      first[h]=i;
+    else if(prepass_equal(f,count,first[h],i)) {
+      rep[i]=first[h];
+      s.ndup++;
+    }
+  }
+  remap_free(&m);
+  free(count);
+
+  /* the reduced family: first[j] is the set of 'f' of its j-th set */
+  family_create_ctx(c,&r,f->grnd_size);
+  for(i=0;i<n;i++)
+    if(rep[i]==i) {
+      first[r.size]=i;
+      family_add_set(&r,f->sets.size[i],family_set(f,i));
+    }
+  s.nsets=r.size;
+  nc=compute_overlap_components_ctx(c,&r,lab);
+
+  /* expand the labels back to the sets of 'f', then to their identifiers:
+     a set equal to a representative alone in its component is alone too */
+  size=(ov_idx_t*)calloc((size_t)nc+1,sizeof(ov_idx_t));
+  for(j=0;j<r.size;j++) {
+    rep[first[r.sets.id[j]]]=-2-lab[j];
+    size[lab[j]]++;
+  }
+  for(i=0;i<n;i++) {
+    if(rep[i]==-1 || (rep[i]>=0 && size[-2-rep[rep[i]]]==1))
+      lab[i]=++nc;
+    else if(rep[i]>=0)
+      lab[i]=-2-rep[rep[i]];
+    else
+      lab[i]=-2-rep[i];
+  }
+  free(size);
+  for(i=0;i<n;i++)
+    t[f->sets.id[i]]=lab[i];
+  family_free(&r);
+
+  /* number the components by smallest identifier */
+  num=(ov_idx_t*)calloc((size_t)nc+1,sizeof(ov_idx_t));
+  for(i=0;i<n;i++) {
+    if(num[t[i]]==0) num[t[i]]=++p;
+    t[i]=num[t[i]];
+  }
+  assert(p==nc);
+
+  free(num);
+  free(first);
+  free(lab);
+  free(rep);
+  if(st) *st=s;
+  return nc;
+}
@@ -0,0 +1,36 @@
+/*
+ *   This source file is part of program computing set overlap classes 
+ *   in linear time.
+ *   Copyright (C) 2007  Michael Rao
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _PREPASS_H_
+#define _PREPASS_H_
+
+#include "overlap.h"
+
+/**
+ * What the prepass removed from a family
+ */
+typedef struct {
+  ov_idx_t nsets; /* sets of the reduced family */
+  ov_idx_t ndup; /* sets equal to another set (collapsed) */
+  ov_idx_t naside; /* sets of size 1 or grnd_size (set aside) */
+} prepass_stats_t;
+
+extern ov_idx_t prepass_components(overlap_ctx_t *c,const family_t *f,ov_idx_t *t,prepass_stats_t *st);
+
+#endif
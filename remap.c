@@ -0,0 +1,119 @@
+/*
+ *   This source file is part of program computing set overlap classes 
+ *   in linear time.
+ *   Copyright (C) 2007  Michael Rao
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdlib.h>
+#include <limits.h>
+#include "remap.h"
+
+#define REMAP_INIT 1024 /* initial size of the table */
+
+/**
+ * Mixes the bits of 'x' (finalizer of MurmurHash3), so that identifiers
+ * which are multiples of a power of 2 are spread in the table.
+ */
+unsigned long long remap_hash(remap_id_t x)
+{
+  x^=x>>33;
+  x*=0xff51afd7ed558ccdULL;
+  x^=x>>33;
+  x*=0xc4ceb9fe1a85ec53ULL;
+  x^=x>>33;
+  return x;
+}
+
+void remap_init(remap_t *m)
+{
+  int i;
+  m->k=0;
+  m->id_cap=REMAP_INIT;
+  m->id=(remap_id_t*)malloc(sizeof(remap_id_t)*m->id_cap);
+  m->mask=2*REMAP_INIT-1;
+  m->keys=(remap_id_t*)malloc(sizeof(remap_id_t)*(m->mask+1));
+  m->vals=(int*)malloc(sizeof(int)*(m->mask+1));
+  for(i=0;i<=m->mask;i++)
+    m->vals[i]=-1;
+}
+
+void remap_free(remap_t *m)
+{
+  free(m->id);
+  free(m->keys);
+  free(m->vals);
+}
+
+/**
+ * Double the size of the table: every element is put back from id[]
+ * Time: O(k)
+ */
+static void remap_grow(remap_t *m)
+{
+  int i;
+  m->mask=2*m->mask+1;
+  m->keys=(remap_id_t*)realloc(m->keys,sizeof(remap_id_t)*(m->mask+1));
+  m->vals=(int*)realloc(m->vals,sizeof(int)*(m->mask+1));
+  for(i=0;i<=m->mask;i++)
+    m->vals[i]=-1;
+  for(i=0;i<m->k;i++) {
+    int h=(int)(remap_hash(m->id[i])&m->mask);
+    while(m->vals[h]>=0) h=(h+1)&m->mask;
+    m->keys[h]=m->id[i];
+    m->vals[h]=i;
+  }
+}
+
+/**
+ * Returns the number of the identifier 'x', or -1 if it is unknown.
+ * Time: O(1) expected
+ */
+int remap_find(const remap_t *m,remap_id_t x)
+{
+  int h=(int)(remap_hash(x)&m->mask);
+  while(m->vals[h]>=0) {
+    if(m->keys[h]==x) return m->vals[h];
+    h=(h+1)&m->mask;
+  }
+  return -1;
+}
+
+/**
+ * Returns the number of the identifier 'x'; a new identifier gets the 
+ * number k. Returns -1 if the table cannot grow any more (about 2^29
+ * elements). The table is at most half full.
+ * Time: O(1) amortized expected
+ */
+int remap_get(remap_t *m,remap_id_t x)
+{
+  int h=(int)(remap_hash(x)&m->mask);
+  while(m->vals[h]>=0) {
+    if(m->keys[h]==x) return m->vals[h];
+    h=(h+1)&m->mask;
+  }
+  if(2*(m->k+1)>m->mask && m->mask>=INT_MAX/2) 
+    return -1;
+  if(m->k==m->id_cap) {
+    m->id_cap*=2;
+    m->id=(remap_id_t*)realloc(m->id,sizeof(remap_id_t)*m->id_cap);
+  }
+  m->id[m->k]=x;
+  m->keys[h]=x;
+  m->vals[h]=m->k++;
+  if(2*m->k>m->mask)
+    remap_grow(m);
+  return m->k-1;
+}
@@ -0,0 +1,50 @@
+/*
+ *   This source file is part of program computing set overlap classes 
+ *   in linear time.
+ *   Copyright (C) 2007  Michael Rao
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _REMAP_H_
+#define _REMAP_H_
+
+/* an element as given by the user: any 64-bit unsigned integer */
+typedef unsigned long long remap_id_t;
+
+/**
+ * Renumbering of sparse element identifiers to 0..k-1, in order of first 
+ * occurence. A hash table (open addressing, linear probing) gives the 
+ * new number of an identifier, id[] gives back the identifier.
+ */
+typedef struct {
+  int k; /* number of distinct identifiers */
+  remap_id_t *id; /* id[i] is the identifier of the element i */
+  int id_cap;
+
+  remap_id_t *keys;
+  int *vals; /* -1 for an empty slot */
+  int mask; /* size of the table - 1 (a power of 2) */
+} remap_t;
+
+extern void remap_init(remap_t *m);
+extern void remap_free(remap_t *m);
+extern int remap_get(remap_t *m,remap_id_t x);
+extern int remap_find(const remap_t *m,remap_id_t x);
+extern unsigned long long remap_hash(remap_id_t x);
+
+/* the identifier of the element 'i' */
+#define remap_id(m,i) ((m)->id[i])
+
+#endif
@@ -17,32 +17,38 @@
  *   along with this program. If not, see <http://www.gnu.org/licenses/>.
  */
 
+#define _POSIX_C_SOURCE 200809L
+
 #include <assert.h>
 #include <stdio.h>
+#include <stdlib.h>
+#include <pthread.h>
 #include "test.h"
 
 /**
  * Returns the relation between set set 'a' and 'b'
+ * 'count' is a table of f->grnd_size entries, all equal to 0 (they are
+ * reset before returning), owned by the caller.
+ * Time: O(|a|+|b|)
  */
-int testset(const family_t *f, int a,int b)
+int testset(const family_t *f,int *count, ov_idx_t a,ov_idx_t b)
 {
   int amb=0,bma=0,aib=0;
   int i;
-  for(i=0;i<f->grnd_size;i++)
-    f->grnd_count[i]=0;
+  const int *sa=family_set(f,a),*sb=family_set(f,b);
 
-  for(i=0;i<f->sets[a].size;i++)
-    f->grnd_count[f->sets[a].set[i]]++;
+  for(i=0;i<f->sets.size[a];i++)
+    count[sa[i]]++;
 
-  for(i=0;i<f->sets[b].size;i++) {
-    if(f->grnd_count[f->sets[b].set[i]]) aib++;
+  for(i=0;i<f->sets.size[b];i++) {
+    if(count[sb[i]]) aib++;
     else bma++; 
-    f->grnd_count[f->sets[b].set[i]]=0;
+    count[sb[i]]=0;
   }
 
-  for(i=0;i<f->sets[a].size;i++) {
-    if(f->grnd_count[f->sets[a].set[i]]) amb++;
-    f->grnd_count[f->sets[a].set[i]]=0;
+  for(i=0;i<f->sets.size[a];i++) {
+    if(count[sa[i]]) amb++;
+    count[sa[i]]=0;
   }
   if(amb && bma && aib) return OVERLAP;
   if(amb==0 && bma==0) return EQUAL;
@@ -61,17 +67,210 @@ int testset(const family_t *f, int a,int b)
  */
 void graph_overlap_create(graph_t *g,const family_t *f)
 {
-  int i,j;
+  ov_idx_t i,j;
+  int *count=(int*)calloc(f->grnd_size>0?f->grnd_size:1,sizeof(int));
 
   graph_create(g,f->size);
 
   for(i=0;i<f->size;i++)
     for(j=i+1;j<f->size;j++) {
-      int r=testset(f,i,j);
+      int r=testset(f,count,i,j);
       if(r==OVERLAP) 
 	graph_add_edge(g,i,j);
     }
   
   graph_sort(g);
+  free(count);
+}
+
+
+/*
+ * Faster reference: the complete overlap graph, from the sizes of the 
+ * intersections |a \cap b|. a and b overlap iff 0 < |a \cap b| < |a|,|b|.
+ * - sparse families: an inverted index (the sets of every element) gives
+ *   the sets b>a meeting a, with |a \cap b|, in time \sum_e deg(e)^2.
+ * - dense families: the sets are bitsets of the ground set, and 
+ *   |a \cap b| is a popcount of a&b, in time n^2 grnd_size/64.
+ * The cheapest one is chosen. The sets a are dealt round-robin to the 
+ * threads, every thread keeps its edges, which are then put in the graph.
+ */
+
+#define TEST_BITS_MAX (1<<28) /* largest bitset table, in words */
+
+typedef unsigned long long test_word_t;
+
+/**
+ * Shared data, and work of a thread
+ */
+typedef struct {
+  const family_t *f;
+  int nthreads;
+  /* inverted index: the sets of e are sets[off[e]..off[e+1]-1], increasing */
+  ov_idx_t *off,*sets;
+  /* bitsets: the set a is bits[a*words .. (a+1)*words-1] */
+  test_word_t *bits;
+  ov_idx_t words;
+} test_shared_t;
+
+typedef struct {
+  test_shared_t *s;
+  int id;
+  ov_idx_t *edges; /* edges[2k]-edges[2k+1] */
+  ov_idx_t nedges,cap;
+} test_thread_t;
+
+static void test_edge(test_thread_t *d,ov_idx_t a,ov_idx_t b)
+{
+  if(d->nedges==d->cap) {
+    d->cap=d->cap?2*d->cap:1024;
+    d->edges=(ov_idx_t*)realloc(d->edges,sizeof(ov_idx_t)*2*(size_t)d->cap);
+  }
+  d->edges[2*d->nedges]=a;
+  d->edges[2*d->nedges+1]=b;
+  d->nedges++;
+}
+
+static void *test_inverted(void *data)
+{
+  test_thread_t *d=(test_thread_t*)data;
+  const test_shared_t *s=d->s;
+  const family_t *f=s->f;
+  int *cnt=(int*)calloc(f->size>0?f->size:1,sizeof(int));
+  ov_idx_t *touched=(ov_idx_t*)malloc(sizeof(ov_idx_t)*(size_t)(f->size>0?f->size:1));
+  ov_idx_t a,j,k;
+  int i;
+
+  for(a=d->id;a<f->size;a+=s->nthreads) {
+    const int *set=family_set(f,a);
+    ov_idx_t nt=0;
+    for(i=0;i<f->sets.size[a];i++)
+      for(j=s->off[set[i]+1]-1;j>=s->off[set[i]] && s->sets[j]>a;j--) {
+	ov_idx_t b=s->sets[j];
+	if(cnt[b]++==0) touched[nt++]=b;
+      }
+    for(k=0;k<nt;k++) {
+      ov_idx_t b=touched[k];
+      if(cnt[b]<f->sets.size[a] && cnt[b]<f->sets.size[b])
+	test_edge(d,a,b);
+      cnt[b]=0;
+    }
+  }
+  free(cnt);
+  free(touched);
+  return NULL;
 }
 
+static void *test_bitsets(void *data)
+{
+  test_thread_t *d=(test_thread_t*)data;
+  const test_shared_t *s=d->s;
+  const family_t *f=s->f;
+  ov_idx_t a,b,w;
+
+  for(a=d->id;a<f->size;a+=s->nthreads) {
+    const test_word_t *ba=s->bits+a*s->words;
+    for(b=a+1;b<f->size;b++) {
+      const test_word_t *bb=s->bits+b*s->words;
+      int inter=0;
+      for(w=0;w<s->words;w++)
+	inter+=__builtin_popcountll(ba[w]&bb[w]);
+      if(inter>0 && inter<f->sets.size[a] && inter<f->sets.size[b])
+	test_edge(d,a,b);
+    }
+  }
+  return NULL;
+}
+
+/**
+ * Compute the complete overlap graph with 'nthreads' threads (see above).
+ * For testing purpose only.
+ * Time: O(min(\sum_e deg(e)^2, size^2 grnd_size/64) / nthreads + edges)
+ */
+void graph_overlap_create_parallel(graph_t *g,const family_t *f,int nthreads)
+{
+  test_shared_t s;
+  test_thread_t *d;
+  pthread_t *th;
+  int *run;
+  void *(*fct)(void *);
+  ov_idx_t n=f->size,e,a;
+  double cost_inv=0,cost_bits;
+  int i,k;
+
+  if(nthreads<1) nthreads=1;
+  s.f=f;
+  s.nthreads=nthreads;
+  s.off=s.sets=NULL;
+  s.bits=NULL;
+  s.words=(f->grnd_size+63)/64;
+
+  /* degrees of the elements, and the cost of both methods */
+  s.off=(ov_idx_t*)calloc((size_t)f->grnd_size+1,sizeof(ov_idx_t));
+  for(a=0;a<n;a++) {
+    const int *set=family_set(f,a);
+    for(i=0;i<f->sets.size[a];i++)
+      s.off[set[i]+1]++;
+  }
+  for(e=1;e<=f->grnd_size;e++)
+    cost_inv+=(double)s.off[e]*s.off[e]/2;
+  cost_bits=(double)n*n*s.words/2;
+
+  if(cost_bits<cost_inv && (double)n*s.words<=TEST_BITS_MAX) {
+    s.bits=(test_word_t*)calloc((size_t)(n*s.words>0?n*s.words:1),sizeof(test_word_t));
+    for(a=0;a<n;a++) {
+      const int *set=family_set(f,a);
+      test_word_t *ba=s.bits+a*s.words;
+      for(i=0;i<f->sets.size[a];i++)
+	ba[set[i]/64]|=(test_word_t)1<<(set[i]%64);
+    }
+    fct=test_bitsets;
+  } else {
+    s.sets=(ov_idx_t*)malloc(sizeof(ov_idx_t)*(size_t)(f->elms_size>0?f->elms_size:1));
+    for(e=0;e<f->grnd_size;e++)
+      s.off[e+1]+=s.off[e];
+    for(a=0;a<n;a++) {
+      const int *set=family_set(f,a);
+      for(i=0;i<f->sets.size[a];i++)
+	s.sets[s.off[set[i]]++]=a;
+    }
+    for(e=f->grnd_size;e>0;e--)
+      s.off[e]=s.off[e-1];
+    s.off[0]=0;
+    fct=test_inverted;
+  }
+
+  d=(test_thread_t*)malloc(sizeof(test_thread_t)*nthreads);
+  th=(pthread_t*)malloc(sizeof(pthread_t)*nthreads);
+  for(k=0;k<nthreads;k++) {
+    d[k].s=&s;
+    d[k].id=k;
+    d[k].edges=NULL;
+    d[k].nedges=d[k].cap=0;
+  }
+  /* the slices of the threads which cannot be created are checked here */
+  run=(int*)malloc(sizeof(int)*nthreads);
+  for(k=1;k<nthreads;k++)
+    run[k]=pthread_create(&th[k],NULL,fct,&d[k])==0;
+  fct(&d[0]);
+  for(k=1;k<nthreads;k++) {
+    if(run[k])
+      pthread_join(th[k],NULL);
+    else
+      fct(&d[k]);
+  }
+  free(run);
+
+  graph_create(g,n);
+  for(k=0;k<nthreads;k++) {
+    for(e=0;e<d[k].nedges;e++)
+      graph_add_edge(g,d[k].edges[2*e],d[k].edges[2*e+1]);
+    free(d[k].edges);
+  }
+  graph_sort(g);
+
+  free(d);
+  free(th);
+  free(s.off);
+  free(s.sets);
+  free(s.bits);
+}
@@ -28,7 +28,8 @@
 #define EQUAL    3
 #define OVERLAP  4
 
-extern int testset(const family_t *f, int a,int b);
+extern int testset(const family_t *f,int *count, ov_idx_t a,ov_idx_t b);
 extern void graph_overlap_create(graph_t *g,const family_t *f);
+extern void graph_overlap_create_parallel(graph_t *g,const family_t *f,int nthreads);
 
 #endif
@@ -1,9 +1,33 @@
 #!/bin/bash
 
+# the components of test3.txt (not sorted by size) and the labels of its 
+# sets are given by the order of the sets in the file
+out=$(mktemp)
+./main -L csr -O $out test3.txt > /dev/null && cmp -s $out test3.csr &&
+./main -L text -O $out test3.txt > /dev/null && cmp -s $out test3.lab &&
+./main -L bin -O $out test3.txt > /dev/null && 
+[[ $(od -An -td4 $out | tr -s ' \n' ' ') == " $(cat test3.lab)" ]]
+r=$?
+rm -f $out
+if [[ $r != 0 ]]
+then
+echo "test3.txt: bad components"
+exit 1
+fi
+
+# the first two sets of test4.txt are equal and adjacent: the prepass 
+# merges them
+./main -P test4.txt | grep -q "1 equal sets"
+if [[ $? != 0 ]]
+then
+echo "test4.txt: equal sets not merged"
+exit 1
+fi
+
 for((i=0;i<100000;i++))
 do
 echo "--------- $i ----------"
-./main 10000 $i
+./main -V 10000 $i
 if [[ $? == 1 ]] 
 then 
 exit 1
@@ -0,0 +1,52 @@
+/*
+ *   This source file is part of program computing set overlap classes 
+ *   in linear time.
+ *   Copyright (C) 2007  Michael Rao
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "overlap.h"
+#include "famio.h"
+
+/**
+ * Converts a family from the text format to the binary format
+ */
+int main(int argc, char **argv)
+{
+  family_t f;
+
+  if(argc!=3) {
+    printf("usage: '%s in.txt out.bin' ('-' is the standard input)\n",argv[0]);
+    exit(1);
+  }
+
+  if(family_read_txt(&f,argv[1],1)<0) {
+    perror("cannot read file\n");
+    exit(1);
+  }
+
+  if(family_write_bin(&f,argv[2])<0) {
+    perror("cannot write file\n");
+    exit(1);
+  }
+
+  printf("++ %lld sets, ground set %d, \\sum_i |X_i| = %lld ++\n",
+	 (long long)f.size,f.grnd_size,(long long)f.elms_size);
+
+  family_free(&f);
+  return 0;
+}
@@ -0,0 +1,106 @@
+/*
+ *   This source file is part of program computing set overlap classes 
+ *   in linear time.
+ *   Copyright (C) 2007  Michael Rao
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdlib.h>
+#include <assert.h>
+#include "uf.h"
+
+/**
+ * Create a union-find structure with 'n' singletons
+ * Time: O(n)
+ */
+void uf_create(uf_t *u,ov_idx_t n)
+{
+  ov_idx_t i;
+  u->n=n;
+  u->p=(ov_idx_t*)malloc(sizeof(ov_idx_t)*(n>0?n:1));
+  for(i=0;i<n;i++)
+    u->p[i]=-1;
+}
+
+/**
+ * Create a union-find structure with 'n' singletons in the table 'p'
+ * of 'n' entries, owned by the caller (uf_free must not be called).
+ * Time: O(n)
+ */
+void uf_init(uf_t *u,ov_idx_t n,ov_idx_t *p)
+{
+  ov_idx_t i;
+  u->n=n;
+  u->p=p;
+  for(i=0;i<n;i++)
+    u->p[i]=-1;
+}
+
+void uf_free(uf_t *u)
+{
+  free(u->p);
+}
+
+/**
+ * Returns the root of the class of 'i' (with path halving)
+ */
+ov_idx_t uf_find(uf_t *u,ov_idx_t i)
+{
+  ov_idx_t *p=u->p;
+  assert(i>=0 && i<u->n);
+  while(p[i]>=0) {
+    if(p[p[i]]>=0) p[i]=p[p[i]];
+    i=p[i];
+  }
+  return i;
+}
+
+/**
+ * Merge the classes of 'i' and 'j' (union by size).
+ * Returns 1 if they were different.
+ */
+int uf_union(uf_t *u,ov_idx_t i,ov_idx_t j)
+{
+  i=uf_find(u,i);
+  j=uf_find(u,j);
+  if(i==j) return 0;
+  if(u->p[i]>u->p[j]) { /* class of i is smaller */
+    ov_idx_t t=i; i=j; j=t;
+  }
+  u->p[i]+=u->p[j];
+  u->p[j]=i;
+  return 1;
+}
+
+/**
+ * Put the classes into 't', numbered from 1 in the order of their 
+ * smallest element (as graph_connected_components does).
+ * The number of a class is first put on its root in 't', thus
+ * no temporary table is needed.
+ * Returns the number of classes.
+ * Time: O(n)
+ */
+ov_idx_t uf_labels(uf_t *u,ov_idx_t *t)
+{
+  ov_idx_t i,p=0;
+  for(i=0;i<u->n;i++)
+    t[i]=0;
+  for(i=0;i<u->n;i++) {
+    ov_idx_t r=uf_find(u,i);
+    if(t[r]==0) t[r]=++p;
+    t[i]=t[r];
+  }
+  return p;
+}
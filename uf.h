@@ -0,0 +1,42 @@
+/*
+ *   This source file is part of program computing set overlap classes 
+ *   in linear time.
+ *   Copyright (C) 2007  Michael Rao
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _UF_H_
+#define _UF_H_
+
+#include "overlap.h"
+
+/**
+ * Union-find structure on {0..n-1}.
+ * p[i]<0 if i is a root (and then -p[i] is the size of its class),
+ * otherwise p[i] is the parent of i.
+ */
+typedef struct {
+  ov_idx_t n;
+  ov_idx_t *p;
+} uf_t;
+
+extern void uf_create(uf_t *u,ov_idx_t n);
+extern void uf_init(uf_t *u,ov_idx_t n,ov_idx_t *p);
+extern void uf_free(uf_t *u);
+extern ov_idx_t uf_find(uf_t *u,ov_idx_t i);
+extern int uf_union(uf_t *u,ov_idx_t i,ov_idx_t j);
+extern ov_idx_t uf_labels(uf_t *u,ov_idx_t *t);
+
+#endif